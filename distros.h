@@ -0,0 +1,79 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DISTROS_H_
+#define _DISTROS_H_
+
+// groups of the distribution list, in the order they are printed
+enum distro_group { ARCH_BASED, DEBIAN_BASED, BSD_BASED, RHEL_BASED, OTHER_DISTRO, NOT_LISTED };
+
+#define RAINBOW NULL // each letter of the name in a different color
+
+// every supported system, adding one only takes a row here (plus res/ascii/<logo>.txt and res/<logo>.png)
+// DISTRO(os-release id, uwufied name, ascii and image logo, group and color in the list)
+#define DISTROS                                                                                      \
+  /* linux */                                                                                        \
+  DISTRO("alpine", "Nyalpine", "alpine", OTHER_DISTRO, BLUE)                                         \
+  DISTRO("amogos", "AmogOwOS", "amogos", DEBIAN_BASED, RED)                                          \
+  DISTRO("android", "Nyandroid", "android", OTHER_DISTRO, GREEN)                                     \
+  DISTRO("arch", "Nyarch Linuwu", "arch", ARCH_BASED, BLUE)                                          \
+  DISTRO("arcolinux", "ArcOwO Linuwu", "arcolinux", ARCH_BASED, BLUE)                                \
+  DISTRO("artix", "Nyartix Linuwu", "artix", ARCH_BASED, MAGENTA)                                    \
+  DISTRO("debian", "Debinyan", "debian", DEBIAN_BASED, RED)                                          \
+  DISTRO("devuan", "Devunyan", "devuan", DEBIAN_BASED, RED)                                          \
+  DISTRO("deepin", "Dewepyn", "deepin", DEBIAN_BASED, RED)                                           \
+  DISTRO("endeavouros", "endeavOwO", "endeavouros", ARCH_BASED, MAGENTA)                             \
+  DISTRO("EndeavourOS", "endeavOwO", "endeavouros", NOT_LISTED, MAGENTA)                             \
+  DISTRO("fedora", "Fedowa", "fedora", RHEL_BASED, BLUE)                                             \
+  DISTRO("femboyos", "FemboyOWOS", "femboyos", OTHER_DISTRO, PINK)                                   \
+  DISTRO("gentoo", "GentOwO", "gentoo", OTHER_DISTRO, PINK)                                          \
+  DISTRO("gnu", "gnUwU", "gnu", OTHER_DISTRO, YELLOW)                                                \
+  DISTRO("guix", "gnUwU gUwUix", "guix", OTHER_DISTRO, YELLOW)                                       \
+  DISTRO("linuxmint", "LinUWU Miwint", "linuxmint", DEBIAN_BASED, GREEN)                             \
+  DISTRO("manjaro", "Myanjawo", "manjaro", ARCH_BASED, GREEN)                                        \
+  DISTRO("manjaro-arm", "Myanjawo AWM", "manjaro-arm", ARCH_BASED, GREEN)                            \
+  DISTRO("neon", "KDE NeOwOn", "neon", DEBIAN_BASED, GREEN)                                          \
+  DISTRO("nixos", "nixOwOs", "nixos", OTHER_DISTRO, BLUE)                                            \
+  DISTRO("opensuse-leap", "OwOpenSUSE Leap", "opensuse-leap", OTHER_DISTRO, GREEN)                   \
+  DISTRO("opensuse-tumbleweed", "OwOpenSUSE Tumbleweed", "opensuse-tumbleweed", OTHER_DISTRO, GREEN) \
+  DISTRO("pop", "PopOwOS", "pop", DEBIAN_BASED, BLUE)                                                \
+  DISTRO("raspbian", "RaspNyan", "raspbian", DEBIAN_BASED, RED)                                      \
+  DISTRO("rocky", "Wocky Linuwu", "rocky", RHEL_BASED, GREEN)                                        \
+  DISTRO("slackware", "Swackwawe", "slackware", OTHER_DISTRO, MAGENTA)                               \
+  DISTRO("solus", "sOwOlus", "solus", OTHER_DISTRO, WHITE)                                           \
+  DISTRO("ubuntu", "Uwuntu", "ubuntu", DEBIAN_BASED, YELLOW)                                         \
+  DISTRO("void", "OwOid", "void", OTHER_DISTRO, GREEN)                                               \
+  DISTRO("xerolinux", "xuwulinux", "xerolinux", ARCH_BASED, BLUE)                                    \
+  /* BSD */                                                                                          \
+  DISTRO("freebsd", "FweeBSD", "freebsd", BSD_BASED, RED)                                            \
+  DISTRO("openbsd", "OwOpenBSD", "openbsd", BSD_BASED, YELLOW)                                       \
+  /* Apple family */                                                                                 \
+  DISTRO("macos", "macOwOS", "macos", BSD_BASED, RAINBOW)                                            \
+  DISTRO("ios", "iOwOS", "ios", BSD_BASED, WHITE)                                                    \
+  /* Windows */                                                                                      \
+  DISTRO("windows", "WinyandOwOws", "windows", OTHER_DISTRO, BLUE)                                   \
+  /* everything else */                                                                              \
+  DISTRO("unknown", "unknown", "unknown", OTHER_DISTRO, WHITE)
+
+#define DISTRO_SLOTS 128 // power of two, at least twice the distros to keep the probes short
+
+// first slot of the distros table (filled by scripts/distro_slots.c) to look for id in
+static inline unsigned distro_slot(const char* id) {
+  unsigned long long hash = 0xcbf29ce484222325ULL; // fnv-1a
+  for (; *id; id++) hash = (hash ^ (unsigned char)*id) * 0x100000001b3ULL;
+  return hash & (DISTRO_SLOTS - 1);
+}
+
+#endif // _DISTROS_H_
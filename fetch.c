@@ -13,10 +13,14 @@
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE // for memmem
+
 #ifdef __APPLE__
   #include <TargetConditionals.h> // for checking iOS
 #endif
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,13 +46,38 @@
   #endif   // defined(__BSD__) || defined(_WIN32)
 #endif     // defined(__APPLE__) || defined(__BSD__)
 #ifndef _WIN32
+  #include <limits.h>
+  #include <poll.h>
   #include <pthread.h> // linux only right now
+  #include <signal.h>
+  #include <stdint.h>
+  #include <stddef.h>
+  #ifdef __linux__
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/timerfd.h>
+  #endif
   #include <sys/ioctl.h>
+  #include <sys/mman.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #if defined(__linux__)
+    #include <sys/vfs.h>
+  #elif defined(__APPLE__) || defined(__BSD__)
+    #include <sys/mount.h>
+    #include <sys/param.h>
+  #endif
+  #include <sys/un.h>
   #include <sys/utsname.h>
+  #include <sys/wait.h>
+  #include <time.h>
 #else // _WIN32
   #include <windows.h>
 CONSOLE_SCREEN_BUFFER_INFO csbi;
 #endif // _WIN32
+#if defined(__x86_64__) || defined(__i386__)
+  #include <cpuid.h>
+#endif
 
 #define LIBFETCH_INTERNAL // to do certain things only when included from the library itself
 #include "fetch.h"
@@ -58,6 +87,12 @@ static bool verbose_enabled = false;
 bool* get_verbose_handle() { return &verbose_enabled; }
 #endif
 
+#define PKG_PROBE_THREADS 4    // package managers probed at the same time
+#define PKG_PROBE_TIMEOUT 2000 // milliseconds a package manager command can run before being killed
+#define PKG_CACHE_FILE "uwufetch.pkgs"
+#define PKG_CACHE_ENTRIES 32   // more than the package managers of any system
+#define GETPROP_TIMEOUT 1000   // milliseconds getprop can run, it only reads a property
+
 #ifndef PKGPATH
   #ifdef __APPLE__
     #define PKGPATH "/usr/local/bin/"
@@ -66,26 +101,14 @@ bool* get_verbose_handle() { return &verbose_enabled; }
   #endif
 #endif
 
-#ifdef __APPLE__
-// buffers where data fetched from sysctl are stored
-  #define CPUBUFFERLEN 128
-
-char cpu_buffer[CPUBUFFERLEN];
-size_t cpu_buffer_len = CPUBUFFERLEN;
-
-// Installed RAM
-int64_t mem_buffer    = 0;
-size_t mem_buffer_len = sizeof(mem_buffer);
-
-// uptime
-struct timeval time_buffer;
-size_t time_buffer_len = sizeof(time_buffer);
-#endif // __APPLE__
-
 struct package_manager {
   char* command_path;
-  char* command_string; // command to get number of packages installed
-  char* pkgman_name;    // name of the package manager
+  char* command_string;                  // command to get number of packages installed
+  char* pkgman_name;                     // name of the package manager
+  int (*count_native)(const char* path); // reads the package database directly, returns -1 if it can't
+  char* db_path;                         // package database read by count_native
+  char* stamp_path;                      // changes every time packages are installed or removed, used to cache the count
+  bool per_user;                         // in the home of the user, see enum pkg_scope
 };
 
 // truncates the given string
@@ -105,6 +128,537 @@ void remove_brackets(char* str) {
       i++;
 }
 
+const char* info_gpu(const struct info* user_info, int i) {
+  return i >= 0 && i < user_info->gpu_count ? user_info->gpu_arena + user_info->gpu_names[i] : NULL;
+}
+
+// names are only appended to the arena, a replaced name stays there until info_clear_gpus
+bool info_set_gpu(struct info* user_info, int i, const char* name, size_t len) {
+  if (i < 0 || i > user_info->gpu_count || i >= MAX_GPUS || len >= sizeof(user_info->gpu_arena) - user_info->gpu_arena_used) return false;
+  char* stored = user_info->gpu_arena + user_info->gpu_arena_used;
+  memcpy(stored, name, len);
+  stored[len]             = '\0';
+  user_info->gpu_names[i] = user_info->gpu_arena_used;
+  user_info->gpu_arena_used += len + 1;
+  if (i == user_info->gpu_count) user_info->gpu_count++;
+  return true;
+}
+
+void info_clear_gpus(struct info* user_info) { user_info->gpu_count = user_info->gpu_arena_used = 0; }
+
+void info_copy_fields(struct info* dst, const struct info* src, unsigned fields) {
+  if (fields & FETCH_USER) {
+    memcpy(dst->user, src->user, sizeof(dst->user));
+    memcpy(dst->host, src->host, sizeof(dst->host));
+  }
+  if (fields & FETCH_SHELL) memcpy(dst->shell, src->shell, sizeof(dst->shell));
+  if (fields & FETCH_MODEL) memcpy(dst->model, src->model, sizeof(dst->model));
+  if (fields & FETCH_KERNEL) memcpy(dst->kernel, src->kernel, sizeof(dst->kernel));
+  if (fields & FETCH_OS) memcpy(dst->os_name, src->os_name, sizeof(dst->os_name));
+  if (fields & FETCH_CPU) memcpy(dst->cpu_model, src->cpu_model, sizeof(dst->cpu_model));
+  if (fields & FETCH_GPU) { // the offsets are still valid in the copy of the arena
+    dst->gpu_count      = src->gpu_count;
+    dst->gpu_arena_used = src->gpu_arena_used;
+    memcpy(dst->gpu_names, src->gpu_names, sizeof(dst->gpu_names));
+    memcpy(dst->gpu_arena, src->gpu_arena, src->gpu_arena_used);
+  }
+  if (fields & FETCH_RESOLUTION) {
+    dst->screen_width  = src->screen_width;
+    dst->screen_height = src->screen_height;
+    dst->monitor_count = src->monitor_count;
+    memcpy(dst->monitors, src->monitors, sizeof(dst->monitors));
+  }
+  if (fields & FETCH_RAM) {
+    dst->ram_total = src->ram_total;
+    dst->ram_used  = src->ram_used;
+  }
+  if (fields & FETCH_PKGS) {
+    dst->pkgs = src->pkgs;
+    memcpy(dst->pkgman_name, src->pkgman_name, sizeof(dst->pkgman_name));
+  }
+  if (fields & FETCH_UPTIME) dst->uptime = src->uptime;
+}
+
+void info_sanitize(struct info* user_info) {
+  // the strings are printed as they are, they have to end in the arrays
+  char* strings[] = {user_info->user, user_info->host, user_info->shell, user_info->model, user_info->kernel,
+                     user_info->os_name, user_info->cpu_model, user_info->pkgman_name, user_info->image_name};
+  size_t sizes[]  = {sizeof(user_info->user), sizeof(user_info->host), sizeof(user_info->shell), sizeof(user_info->model), sizeof(user_info->kernel),
+                     sizeof(user_info->os_name), sizeof(user_info->cpu_model), sizeof(user_info->pkgman_name), sizeof(user_info->image_name)};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) strings[i][sizes[i] - 1] = '\0';
+  if (user_info->monitor_count < 0 || user_info->monitor_count > MAX_MONITORS) user_info->monitor_count = 0;
+  if (user_info->gpu_count < 0 || user_info->gpu_count > MAX_GPUS) user_info->gpu_count = 0;
+  user_info->gpu_arena[sizeof(user_info->gpu_arena) - 1] = '\0';
+  for (int i = 0; i < user_info->gpu_count; i++)
+    if (user_info->gpu_names[i] >= sizeof(user_info->gpu_arena)) user_info->gpu_names[i] = sizeof(user_info->gpu_arena) - 1; // empty name
+}
+
+// calls found for every line of data that looks like key<separator>value with one of the given keys
+// spaces around keys and values are skipped, value is not terminated, returns the number of lines found
+int scan_keys(const char* data, size_t len, char separator, const char* const keys[], int key_count, scan_fn found, void* arg) {
+  size_t key_lens[key_count];
+  for (int i = 0; i < key_count; i++) key_lens[i] = strlen(keys[i]);
+  int found_count = 0;
+  for (const char *line = data, *end = data + len; line < end;) {
+    const char* eol = memchr(line, '\n', end - line);
+    if (!eol) eol = end;
+    const char* sep = memchr(line, separator, eol - line);
+    if (sep) {
+      const char *key = line, *key_end = sep, *value = sep + 1, *value_end = eol;
+      while (key < key_end && (*key == ' ' || *key == '\t')) key++;
+      while (key_end > key && (key_end[-1] == ' ' || key_end[-1] == '\t')) key_end--;
+      while (value < value_end && (*value == ' ' || *value == '\t')) value++;
+      while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t' || value_end[-1] == '\r')) value_end--;
+      for (int i = 0; i < key_count; i++)
+        if (key_lens[i] == (size_t)(key_end - key) && memcmp(keys[i], key, key_lens[i]) == 0) {
+          found(i, value, value_end - value, arg);
+          found_count++;
+          break;
+        }
+    }
+    line = eol + 1;
+  }
+  return found_count;
+}
+
+// reads a whole file with a single read() into buffer and scans it with scan_keys
+// buffer is terminated so values can be parsed with strtol, returns -1 if the file could not be read
+int scan_file(const char* path, char* buffer, size_t len, char separator, const char* const keys[], int key_count, scan_fn found, void* arg) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  ssize_t read_len = read(fd, buffer, len - 1);
+  close(fd);
+  if (read_len < 0) return -1;
+  if ((size_t)read_len == len - 1) {
+    LOG_W("%s does not fit in %zu bytes, reading only its start", path, len);
+  }
+  buffer[read_len] = '\0';
+  return scan_keys(buffer, read_len, separator, keys, key_count, found, arg);
+}
+
+static char cache_dir_override[512];                               // cache directory set by the config
+static bool cache_dir_found;                                       // cache_dir is found again after the override changes
+static pthread_mutex_t cache_dir_lock = PTHREAD_MUTEX_INITIALIZER; // uwufetchd changes it while collecting
+
+// uses dir instead of the default cache directory, the next cached files go there
+void set_cache_dir(const char* dir) {
+  pthread_mutex_lock(&cache_dir_lock);
+  snprintf(cache_dir_override, sizeof(cache_dir_override), "%s", dir ? dir : "");
+  cache_dir_found = false;
+  pthread_mutex_unlock(&cache_dir_lock);
+}
+
+#ifndef _WIN32
+// replaces a leading ~ with the home directory, returns false if it is not set
+static bool expand_home(const char* path, char* expanded, size_t len) {
+  const char* home = getenv("HOME");
+  if (path[0] != '~')
+    snprintf(expanded, len, "%s", path);
+  else if (home)
+    snprintf(expanded, len, "%s%s", home, path + 1);
+  return path[0] != '~' || home;
+}
+
+// maps a whole file in memory (map is NULL for empty files), returns -1 if it can't be opened
+static int map_file(const char* path, const unsigned char** map, size_t* len) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  struct stat st;
+  *map = NULL;
+  *len = 0;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      *map = addr;
+      *len = st.st_size;
+    }
+  }
+  close(fd);
+  return *map || *len == 0 ? 0 : -1;
+}
+
+// reads a small file relative to dir_fd, without the trailing newline, returns its length or -1
+static int read_small_file(int dir_fd, const char* path, char* buffer, size_t len) {
+  int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  ssize_t read_len = read(fd, buffer, len - 1);
+  close(fd);
+  if (read_len < 0) return -1;
+  while (read_len > 0 && (buffer[read_len - 1] == '\n' || buffer[read_len - 1] == ' ')) read_len--;
+  buffer[read_len] = '\0';
+  return read_len;
+}
+
+static char cache_dir[PATH_MAX]; // found by find_cache_dir, guarded by cache_dir_lock
+
+// true if path is on a local filesystem, a cache on a network one would be shared between hosts and slow to reach
+static bool is_local_dir(const char* path) {
+  #if defined(__linux__)
+  static const uint32_t network_fs[] = {0x6969 /* nfs */, 0x517b /* smb */, 0xff534d42 /* cifs */, 0xfe534d42 /* smb2 */,
+                                        0x73757245 /* coda */, 0x5346414f /* afs */, 0x00c36400 /* ceph */, 0x0bd00bd0 /* lustre */};
+  struct statfs fs;
+  if (statfs(path, &fs) != 0) return false;
+  for (size_t i = 0; i < sizeof(network_fs) / sizeof(network_fs[0]); i++)
+    if ((uint32_t)fs.f_type == network_fs[i]) return false;
+  return true;
+  #elif defined(__APPLE__) || defined(__BSD__)
+  struct statfs fs;
+  return statfs(path, &fs) == 0 && (fs.f_flags & MNT_LOCAL);
+  #else
+  return access(path, W_OK) == 0;
+  #endif
+}
+
+// creates dir/uwufetch/<machine-id or hostname> in path, if dir is local
+static bool make_cache_dir(const char* dir, char* path, size_t len) {
+  char host_key[256];
+  if (!dir || !dir[0] || !is_local_dir(dir)) return false;
+  if (read_small_file(AT_FDCWD, "/etc/machine-id", host_key, sizeof(host_key)) <= 0 && gethostname(host_key, sizeof(host_key)) != 0) return false;
+  host_key[sizeof(host_key) - 1] = '\0';
+  for (char* c = host_key; *c; c++)
+    if (*c == '/') *c = '_';
+  snprintf(path, len, "%s/uwufetch", dir);
+  if (mkdir(path, 0700) != 0 && errno != EEXIST) return false;
+  snprintf(path, len, "%s/uwufetch/%s", dir, host_key);
+  return mkdir(path, 0700) == 0 || errno == EEXIST;
+}
+
+// the runtime directory first, then the cache one, skipping network filesystems unless the config asks for a directory
+static void find_cache_dir(void) {
+  char dir[PATH_MAX];
+  if (cache_dir_override[0]) {
+    if (!expand_home(cache_dir_override, cache_dir, sizeof(cache_dir)) || (mkdir(cache_dir, 0700) != 0 && errno != EEXIST)) cache_dir[0] = '\0';
+    return;
+  }
+  snprintf(dir, sizeof(dir), "/run/user/%d", (int)getuid());
+  if (make_cache_dir(getenv("XDG_RUNTIME_DIR"), cache_dir, sizeof(cache_dir)) || make_cache_dir(dir, cache_dir, sizeof(cache_dir))) return;
+  if (getenv("XDG_CACHE_HOME"))
+    snprintf(dir, sizeof(dir), "%s", getenv("XDG_CACHE_HOME"));
+  else if (getenv("HOME"))
+    snprintf(dir, sizeof(dir), "%s/.cache", getenv("HOME"));
+  if ((getenv("XDG_CACHE_HOME") || getenv("HOME")) && (mkdir(dir, 0700) == 0 || errno == EEXIST) && make_cache_dir(dir, cache_dir, sizeof(cache_dir))) return;
+  LOG_W("no local cache directory found, nothing will be cached");
+  cache_dir[0] = '\0';
+}
+
+// path of a file in the cache directory, returns false if there is none or the path does not fit (it would name another file)
+bool get_cache_path(const char* name, char* path, size_t len) {
+  pthread_mutex_lock(&cache_dir_lock);
+  if (!cache_dir_found) find_cache_dir();
+  cache_dir_found = true;
+  bool fits       = cache_dir[0] && snprintf(path, len, "%s/%s", cache_dir, name) < (int)len;
+  pthread_mutex_unlock(&cache_dir_lock);
+  return fits;
+}
+#else
+bool get_cache_path(const char* name, char* path, size_t len) {
+  pthread_mutex_lock(&cache_dir_lock);
+  bool fits = false;
+  if (cache_dir_override[0])
+    fits = snprintf(path, len, "%s/%s", cache_dir_override, name) < (int)len;
+  else if (getenv("HOME"))
+    fits = snprintf(path, len, "%s/.cache/%s", getenv("HOME"), name) < (int)len;
+  pthread_mutex_unlock(&cache_dir_lock);
+  return fits;
+}
+#endif // _WIN32
+
+#ifndef _WIN32
+// creates a unique temporary file next to path, to be renamed over it (two threads of a process can be writing it)
+static FILE* create_temp(const char* path, char* tmp_file, size_t len) {
+  snprintf(tmp_file, len, "%s.XXXXXX", path);
+  int tmp_fd = mkstemp(tmp_file);
+  if (tmp_fd < 0) return NULL;
+  FILE* tmp_fp = fdopen(tmp_fd, "w");
+  if (!tmp_fp) {
+    close(tmp_fd);
+    remove(tmp_file);
+  }
+  return tmp_fp;
+}
+
+static uint16_t read_be16(const unsigned char* p) { return p[0] << 8 | p[1]; }
+static uint32_t read_be32(const unsigned char* p) { return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+
+#define KILL_WAIT 50 // milliseconds waited for a killed command to exit
+
+static _Thread_local bool command_killed; // set when run_command kills a command, the task running on this thread was cut short
+
+static long long now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// starts a shell command in its own process group, sets output_fd to the read end of its output, returns -1 on error
+static pid_t spawn_command(const char* command, int* output_fd) {
+  int fds[2];
+  #ifdef __linux__
+  if (pipe2(fds, O_CLOEXEC) != 0) return -1; // commands run by other threads must not inherit the pipe
+  #else
+  if (pipe(fds) != 0) return -1;
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  #endif
+  pid_t pid = fork();
+  if (pid == 0) {
+    setpgid(0, 0); // own process group, so the whole pipeline can be killed
+    dup2(fds[1], STDOUT_FILENO);
+    execl("/bin/sh", "sh", "-c", command, (char*)NULL);
+    _exit(127);
+  }
+  close(fds[1]);
+  if (pid < 0) {
+    close(fds[0]);
+    return -1;
+  }
+  setpgid(pid, pid); // also here, the deadline can pass before the child runs (EACCES once it ran exec, ESRCH if it exited)
+  *output_fd = fds[0];
+  return pid;
+}
+
+// kills a command and its pipeline, and reaps it if it exits within KILL_WAIT
+static void kill_command(pid_t pid) {
+  if (kill(-pid, SIGKILL) != 0) kill(pid, SIGKILL);
+  // a killed command exits right away, but the deadline must hold even if it does not
+  for (int i = 0; i < KILL_WAIT && waitpid(pid, NULL, WNOHANG) == 0; i++) usleep(1000);
+}
+
+  #ifdef __linux__
+    #define ASYNC_COMMANDS 32 // commands a collection of fetch_start can start, more than all the collectors run
+
+// a command started by a collector of fetch_start, which runs again with its output once it is done
+struct async_command {
+  char* command;
+  char* output;
+  size_t size;       // of output
+  int read_len;      // bytes read, -1 if it was killed
+  int fd;            // read end of its output, -1 once it is done
+  pid_t pid;         // 0 once it is reaped
+  long long kill_at; // now_ms() time, 0 for none
+  unsigned waiting;  // bitmask of the tasks that need its output
+};
+
+// commands of a fetch_start collection, driven by fetch_drain on the thread of the caller
+struct command_table {
+  struct async_command commands[ASYNC_COMMANDS];
+  int count;
+  int poll_fd;  // epoll fd the output of the commands is added to
+  int task;     // index of the task running on this thread
+  bool pending; // the running task needs the output of a command that is not done
+};
+
+static _Thread_local struct command_table* async_commands; // set while fetch_start and fetch_drain run a task
+
+// run_command of the tasks of fetch_start: returns the output of command once it is done, until then starts it and
+// returns -1 with async_commands->pending set, the task is run again when it is done
+static int async_command(const char* command, char* output, size_t len, int timeout) {
+  struct command_table* table = async_commands;
+  if (table->pending) return -1; // what comes next in the task can depend on the output it is waiting for
+  for (int i = 0; i < table->count; i++) {
+    struct async_command* started = &table->commands[i];
+    if (strcmp(started->command, command) != 0) continue;
+    if (started->fd >= 0) {
+      started->waiting |= 1U << table->task;
+      table->pending = true;
+      return -1;
+    }
+    if (started->read_len < 0) {
+      command_killed = true;
+      return -1;
+    }
+    size_t read_len = (size_t)started->read_len < len ? (size_t)started->read_len : len - 1;
+    memcpy(output, started->output, read_len);
+    output[read_len] = '\0';
+    return read_len;
+  }
+  if (timeout == 0) { // nothing would be read anyway, the output of the commands already done still is
+    LOG_W("no time left to run '%s'", command);
+    return -1;
+  }
+  if (table->count == ASYNC_COMMANDS) {
+    LOG_E("too many commands to run '%s'", command);
+    return -1;
+  }
+  struct async_command* started = &table->commands[table->count];
+  *started                      = (struct async_command){strdup(command), malloc(len), len, 0, -1, 0, timeout < 0 ? 0 : now_ms() + timeout, 1U << table->task};
+  if (!started->command || !started->output || (started->pid = spawn_command(command, &started->fd)) < 0) {
+    free(started->command);
+    free(started->output);
+    return -1;
+  }
+  struct epoll_event event = {.events = EPOLLIN};
+  fcntl(started->fd, F_SETFL, O_NONBLOCK);
+  epoll_ctl(table->poll_fd, EPOLL_CTL_ADD, started->fd, &event);
+  table->count++;
+  table->pending = true;
+  return -1;
+}
+  #endif
+
+// sets whether the task running on this thread waits for a command of fetch_start, returns what it was
+static bool swap_pending(bool pending) {
+  #ifdef __linux__
+  if (!async_commands) return false;
+  bool was                = async_commands->pending;
+  async_commands->pending = pending;
+  return was;
+  #else
+  (void)pending;
+  return false;
+  #endif
+}
+
+// true when the task running on this thread belongs to a fetch_start collection, which starts no thread
+static bool collecting_async(void) {
+  #ifdef __linux__
+  return async_commands != NULL;
+  #else
+  return false;
+  #endif
+}
+
+// runs a shell command and reads its output, killing it if it does not exit within timeout milliseconds
+// a negative timeout waits for it to exit, returns the number of bytes read, or -1 if it could not be run or timed out
+static int run_command(const char* command, char* output, size_t len, int timeout) {
+  output[0] = '\0';
+  #ifdef __linux__
+  if (async_commands) return async_command(command, output, len, timeout);
+  #endif
+  if (timeout == 0) { // nothing would be read anyway
+    LOG_W("no time left to run '%s'", command);
+    return -1;
+  }
+  int output_fd;
+  pid_t pid = spawn_command(command, &output_fd);
+  if (pid < 0) return -1;
+  size_t read_len    = 0;
+  long long deadline = now_ms() + timeout;
+  bool timed_out     = false;
+  for (;;) {
+    struct pollfd pfd = {output_fd, POLLIN, 0};
+    long long left    = timeout < 0 ? -1 : deadline - now_ms();
+    if ((timeout >= 0 && left <= 0) || poll(&pfd, 1, left) == 0) {
+      timed_out = true;
+      break;
+    }
+    char discard[256]; // keep draining the pipe once output is full
+    ssize_t n = read_len + 1 < len ? read(output_fd, output + read_len, len - read_len - 1) : read(output_fd, discard, sizeof(discard));
+    if (n <= 0) break;
+    if (read_len + 1 < len) read_len += n;
+  }
+  close(output_fd);
+  if (timeout < 0)
+    waitpid(pid, NULL, 0);
+  else // it can keep running after closing its output
+    while (!timed_out && waitpid(pid, NULL, WNOHANG) == 0) {
+      if (now_ms() >= deadline) timed_out = true;
+      else usleep(1000);
+    }
+  if (timed_out) {
+    LOG_W("'%s' timed out after %dms, killing it", command, timeout);
+    command_killed = true;
+    kill_command(pid);
+  }
+  output[read_len] = '\0';
+  return timed_out ? -1 : (int)read_len;
+}
+
+// milliseconds a command can run without going past deadline (a now_ms() time, 0 for none), at most timeout if it is not negative
+static int command_timeout(long long deadline, int timeout) {
+  if (!deadline) return timeout;
+  long long left = deadline - now_ms();
+  if (left < 0) left = 0;
+  return timeout >= 0 && timeout < left ? timeout : (int)left;
+}
+
+// runs a command like popen does, but reading all of its output into output first, so that it can be killed at the deadline
+// returns NULL if it could not be run, timed out or printed nothing, the stream has to be closed with close_command
+static FILE* open_command(const char* command, long long deadline, char* output, size_t len) {
+  int read_len = run_command(command, output, len, command_timeout(deadline, -1));
+  return read_len > 0 ? fmemopen(output, read_len, "r") : NULL;
+}
+#endif // _WIN32
+
+static void close_command(FILE* command) {
+#ifdef _WIN32
+  pclose(command);
+#else
+  fclose(command);
+#endif
+}
+
+// small files read ahead by get_info and handed to the collectors
+#define BATCH_FILES 8
+#define BATCH_SIZE 16384 // bytes shared by all the files of a batch
+struct file_batch {
+  struct file_read {
+    const char* path;
+    char* buffer;
+    size_t len;
+    int result; // bytes read, or -1 if the file could not be read
+  } files[BATCH_FILES];
+  int count;
+  size_t used;
+  char data[BATCH_SIZE];
+};
+
+static void batch_add(struct file_batch* batch, const char* path, size_t len) {
+  if (batch->count == BATCH_FILES || batch->used + len > BATCH_SIZE) return; // will be read by its collector
+  batch->files[batch->count++] = (struct file_read){path, batch->data + batch->used, len, -1};
+  batch->used += len;
+}
+
+static const struct file_read* batch_find(const struct file_batch* batch, const char* path) {
+  for (int i = 0; batch && i < batch->count; i++)
+    if (strcmp(batch->files[i].path, path) == 0) return &batch->files[i];
+  return NULL;
+}
+
+#ifndef _WIN32
+static int read_batch_file(struct file_read* file) {
+  int fd = open(file->path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  ssize_t read_len = pread(fd, file->buffer, file->len - 1, 0);
+  close(fd);
+  return read_len < 0 ? -1 : (int)read_len;
+}
+#endif
+
+// reads every file added to the batch
+static void read_batch(struct file_batch* batch) {
+  for (int i = 0; i < batch->count; i++) {
+    struct file_read* file = &batch->files[i];
+#ifndef _WIN32
+    file->result = read_batch_file(file);
+#else
+    file->result = -1;
+#endif
+    if (file->result >= 0) file->buffer[file->result] = '\0';
+  }
+}
+
+// like read_small_file, using the batched read of path if there is one
+static int read_batched(const struct file_batch* batch, const char* path, char* buffer, size_t len) {
+  const struct file_read* file = batch_find(batch, path);
+#ifndef _WIN32
+  if (!file) return read_small_file(AT_FDCWD, path, buffer, len);
+#endif
+  if (!file || file->result < 0) return -1;
+  int read_len = (size_t)file->result < len ? file->result : (int)len - 1;
+  while (read_len > 0 && (file->buffer[read_len - 1] == '\n' || file->buffer[read_len - 1] == ' ')) read_len--;
+  memcpy(buffer, file->buffer, read_len);
+  buffer[read_len] = '\0';
+  return read_len;
+}
+
+// like scan_file, using the batched read of path if there is one
+static int scan_batched(const struct file_batch* batch, const char* path, char* buffer, size_t len, char separator, const char* const keys[], int key_count, scan_fn found, void* arg) {
+  const struct file_read* file = batch_find(batch, path);
+  if (!file) return scan_file(path, buffer, len, separator, keys, key_count, found, arg);
+  return file->result < 0 ? -1 : scan_keys(file->buffer, file->result, separator, keys, key_count, found, arg);
+}
+
 void get_twidth(struct info* user_info) {
   LOG_I("getting terminal width");
   // get terminal width used to truncate long names
@@ -137,43 +691,244 @@ void get_sys(struct info* user_info) {
 #endif
 }
 
+#ifdef __linux__
+// arm cpu part names by midr implementer and part number, as lscpu names them
+static const struct arm_part {
+  uint8_t implementer;
+  uint16_t part;
+  const char* name;
+} arm_parts[] = {
+    {0x41, 0xc07, "Cortex-A7"},
+    {0x41, 0xc09, "Cortex-A9"},
+    {0x41, 0xc0f, "Cortex-A15"},
+    {0x41, 0xd01, "Cortex-A32"},
+    {0x41, 0xd02, "Cortex-A34"},
+    {0x41, 0xd03, "Cortex-A53"},
+    {0x41, 0xd04, "Cortex-A35"},
+    {0x41, 0xd05, "Cortex-A55"},
+    {0x41, 0xd06, "Cortex-A65"},
+    {0x41, 0xd07, "Cortex-A57"},
+    {0x41, 0xd08, "Cortex-A72"},
+    {0x41, 0xd09, "Cortex-A73"},
+    {0x41, 0xd0a, "Cortex-A75"},
+    {0x41, 0xd0b, "Cortex-A76"},
+    {0x41, 0xd0c, "Neoverse-N1"},
+    {0x41, 0xd0d, "Cortex-A77"},
+    {0x41, 0xd0e, "Cortex-A76AE"},
+    {0x41, 0xd40, "Neoverse-V1"},
+    {0x41, 0xd41, "Cortex-A78"},
+    {0x41, 0xd44, "Cortex-X1"},
+    {0x41, 0xd46, "Cortex-A510"},
+    {0x41, 0xd47, "Cortex-A710"},
+    {0x41, 0xd48, "Cortex-X2"},
+    {0x41, 0xd49, "Neoverse-N2"},
+    {0x41, 0xd4b, "Cortex-A78C"},
+    {0x41, 0xd4d, "Cortex-A715"},
+    {0x41, 0xd4e, "Cortex-X3"},
+    {0x41, 0xd4f, "Neoverse-V2"},
+    {0x41, 0xd80, "Cortex-A520"},
+    {0x41, 0xd81, "Cortex-A720"},
+    {0x41, 0xd82, "Cortex-X4"},
+    {0x43, 0x0af, "ThunderX2 99xx"},
+    {0x46, 0x001, "A64FX"},
+    {0x48, 0xd01, "TaiShan-v110"},
+    {0x51, 0x800, "Kryo-2XX-Gold"},
+    {0x51, 0x801, "Kryo-2XX-Silver"},
+    {0x51, 0x802, "Kryo-3XX-Gold"},
+    {0x51, 0x803, "Kryo-3XX-Silver"},
+    {0x51, 0x804, "Kryo-4XX-Gold"},
+    {0x51, 0x805, "Kryo-4XX-Silver"},
+    {0x51, 0xc00, "Falkor"},
+    {0x51, 0xc01, "Saphira"},
+    {0x61, 0x022, "Icestorm"},
+    {0x61, 0x023, "Firestorm"},
+    {0x61, 0x024, "Icestorm-Pro"},
+    {0x61, 0x025, "Firestorm-Pro"},
+    {0x61, 0x028, "Icestorm-Max"},
+    {0x61, 0x029, "Firestorm-Max"},
+    {0x61, 0x032, "Blizzard"},
+    {0x61, 0x033, "Avalanche"},
+    {0x61, 0x034, "Blizzard-Pro"},
+    {0x61, 0x035, "Avalanche-Pro"},
+    {0x61, 0x038, "Blizzard-Max"},
+    {0x61, 0x039, "Avalanche-Max"},
+    {0xc0, 0xac3, "Ampere-1"},
+    {0xc0, 0xac4, "Ampere-1a"},
+};
+
+// decodes the midr register of a cpu, returns NULL on x86 or unknown parts
+static const char* arm_part_name(int cpu) {
+  char path[128], value[32];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/regs/identification/midr_el1", cpu);
+  if (read_small_file(AT_FDCWD, path, value, sizeof(value)) <= 0) return NULL;
+  unsigned long long midr = strtoull(value, NULL, 16);
+  int implementer = midr >> 24 & 0xff, part = midr >> 4 & 0xfff;
+  for (size_t i = 0; i < sizeof(arm_parts) / sizeof(arm_parts[0]); i++)
+    if (arm_parts[i].implementer == implementer && arm_parts[i].part == part) return arm_parts[i].name;
+  LOG_I("unknown arm part %02x:%03x", implementer, part);
+  return NULL;
+}
+
+  #define MAX_CPUS 8192
+
+// marks the cpus of a sysfs cpu list like "0-3,8-11" in a bitmap, returns how many there are
+static int parse_cpu_list(const char* list, uint64_t* bitmap) {
+  int count = 0;
+  for (const char* p = list; *p;) {
+    char* end;
+    long first = strtol(p, &end, 10), last = first;
+    if (end == p) break;
+    if (*end == '-') last = strtol(end + 1, &end, 10);
+    for (long cpu = first; cpu <= last && cpu < MAX_CPUS; cpu++, count++)
+      if (bitmap) bitmap[cpu / 64] |= 1ULL << cpu % 64;
+    p = *end == ',' ? end + 1 : end;
+  }
+  return count;
+}
+
+// counts sockets, cores and threads of the online cpus, reading each core and package list once
+static bool get_cpu_topology(int* sockets, int* cores, int* threads) {
+  uint64_t online[MAX_CPUS / 64], seen_cores[MAX_CPUS / 64], seen_packages[MAX_CPUS / 64]; // 3KiB, collector stacks have room for it
+  char list[4096], path[128];
+  int cpu_fd = open("/sys/devices/system/cpu", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (cpu_fd < 0) return false;
+  memset(online, 0, sizeof(online));
+  memset(seen_cores, 0, sizeof(seen_cores));
+  memset(seen_packages, 0, sizeof(seen_packages));
+  *sockets = *cores = *threads = 0;
+  if (read_small_file(cpu_fd, "online", list, sizeof(list)) > 0) *threads = parse_cpu_list(list, online);
+  for (int cpu = 0; cpu < MAX_CPUS && *threads; cpu++) {
+    if (!(online[cpu / 64] >> cpu % 64 & 1)) continue;
+    if (!(seen_cores[cpu / 64] >> cpu % 64 & 1)) { // first thread of a core
+      snprintf(path, sizeof(path), "cpu%d/topology/core_cpus_list", cpu);
+      if (read_small_file(cpu_fd, path, list, sizeof(list)) <= 0) {
+        snprintf(path, sizeof(path), "cpu%d/topology/thread_siblings_list", cpu); // before linux 5.4
+        if (read_small_file(cpu_fd, path, list, sizeof(list)) <= 0) break;
+      }
+      parse_cpu_list(list, seen_cores);
+      (*cores)++;
+    }
+    if (!(seen_packages[cpu / 64] >> cpu % 64 & 1)) { // first thread of a socket
+      snprintf(path, sizeof(path), "cpu%d/topology/package_cpus_list", cpu);
+      if (read_small_file(cpu_fd, path, list, sizeof(list)) <= 0) {
+        snprintf(path, sizeof(path), "cpu%d/topology/core_siblings_list", cpu);
+        if (read_small_file(cpu_fd, path, list, sizeof(list)) <= 0) break;
+      }
+      parse_cpu_list(list, seen_packages);
+      (*sockets)++;
+    }
+  }
+  close(cpu_fd);
+  LOG_I("%d sockets, %d cores, %d threads", *sockets, *cores, *threads);
+  return *threads && *cores && *sockets;
+}
+#endif // __linux__
+
 // tries to get cpu name
 void* get_cpu(void* argp) {
   if (!((struct thread_varg*)argp)->thread_flags[0]) return 0;
   char* buffer           = ((struct thread_varg*)argp)->buffer;
   struct info* user_info = ((struct thread_varg*)argp)->user_info;
-  FILE* cpuinfo          = ((struct thread_varg*)argp)->cpuinfo;
   LOG_I("getting cpu name");
-  if (cpuinfo) {
-    while (fgets(buffer, BUFFER_SIZE, cpuinfo)) {
-#ifdef __BSD__
+#ifdef __APPLE__
+  size_t cpu_model_len = sizeof(user_info->cpu_model);
+  if (sysctlbyname("machdep.cpu.brand_string", user_info->cpu_model, &cpu_model_len, NULL, 0) != 0) user_info->cpu_model[0] = '\0'; // cpu name
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int brand[13] = {0}; // 48 bytes of brand string and a terminator
+  if (!user_info->cpu_model[0] && __get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+    for (int i = 0; i < 3; i++)
+      __get_cpuid(0x80000002 + i, &brand[i * 4], &brand[i * 4 + 1], &brand[i * 4 + 2], &brand[i * 4 + 3]);
+    char* brand_string = (char*)brand;
+    while (*brand_string == ' ') brand_string++;
+    for (int len = strlen(brand_string); len > 0 && brand_string[len - 1] == ' '; len--) brand_string[len - 1] = '\0';
+    sprintf(user_info->cpu_model, "%s", brand_string);
+  }
+#endif
+#ifdef __linux__
+  int sockets, cores, threads;
+  bool topology = get_cpu_topology(&sockets, &cores, &threads);
+  if (!user_info->cpu_model[0]) {
+    const char* part = arm_part_name(0);
+    if (part) sprintf(user_info->cpu_model, "%s", part);
+  }
+#elif !defined(__BSD__) && !defined(_WIN32)
+  bool topology = false;
+#endif
+#ifndef _WIN32
+  if (!user_info->cpu_model[0]) { // nothing faster knows the name
+  #ifdef __BSD__
+    char command_output[BUFFER_SIZE];
+    FILE* cpuinfo = open_command("sysctl hw.model", ((struct thread_varg*)argp)->deadline, command_output, sizeof(command_output));
+  #else
+    FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
+  #endif
+    while (cpuinfo && fgets(buffer, BUFFER_SIZE, cpuinfo)) {
+  #ifdef __BSD__
       if (sscanf(buffer, "hw.model"
-  #ifdef __FREEBSD__
+    #ifdef __FREEBSD__
                          ": "
-  #elif defined(__OPENBSD__)
+    #elif defined(__OPENBSD__)
                          "="
-  #endif
+    #endif
                          "%[^\n]",
                  user_info->cpu_model))
         break;
-#else
+  #else
       if (sscanf(buffer, "model name    : %[^\n]", user_info->cpu_model)) break;
-#endif // __BSD__
+  #endif // __BSD__
     }
+  #ifndef __BSD__
+    if (cpuinfo && strlen(user_info->cpu_model) == 0 && !topology) {
+      LOG_E("failed to get cpu name");
+      rewind(cpuinfo);
+      char cores[4] = "";
+      while (fgets(buffer, BUFFER_SIZE, cpuinfo)) // get the last core number
+        sscanf(buffer, "processor%*[    |	]: %[^\n]", cores);
+      cores[strlen(cores) - 1] += 1; // should be a number
+      sprintf(user_info->cpu_model, "%s Cores", cores);
+    }
+    if (cpuinfo) fclose(cpuinfo);
+  #else
+    if (cpuinfo) close_command(cpuinfo);
+  #endif
   }
-  if (strlen(user_info->cpu_model) == 0) {
-    LOG_E("failed to get cpu name");
-    rewind(cpuinfo);
-    char cores[4] = "";
-    while (fgets(buffer, BUFFER_SIZE, cpuinfo)) // get the last core number
-      sscanf(buffer, "processor%*[    |	]: %[^\n]", cores);
-    cores[strlen(cores) - 1] += 1; // should be a number
-    sprintf(user_info->cpu_model, "%s Cores", cores);
+#endif // _WIN32
+#ifdef __linux__
+  if (topology) { // e.g. 2x AMD EPYC 9654 96-Core Processor (192C/384T)
+    char cpu_name[sizeof(user_info->cpu_model)];
+    sprintf(cpu_name, "%s", user_info->cpu_model);
+    int len = 0;
+    if (!cpu_name[0])
+      sprintf(user_info->cpu_model, "%d Cores", threads);
+    else if (sockets > 1)
+      len = snprintf(user_info->cpu_model, sizeof(user_info->cpu_model), "%dx %s (%dC/%dT)", sockets, cpu_name, cores, threads);
+    else
+      len = snprintf(user_info->cpu_model, sizeof(user_info->cpu_model), "%s (%dC/%dT)", cpu_name, cores, threads);
+    if (len >= (int)sizeof(user_info->cpu_model)) sprintf(user_info->cpu_model, "%s", cpu_name); // no room left for the topology
   }
+#endif
   LOG_V(user_info->cpu_model);
+  ((struct thread_varg*)argp)->unavailable = !user_info->cpu_model[0];
   return 0;
 }
 
+// scan_fn storing numeric values in the array passed as arg, at the index of their key
+static void store_long(int key, const char* value, size_t len, void* arg) {
+  (void)len;
+  ((long*)arg)[key] = strtol(value, NULL, 10);
+}
+
+// scan_fn copying a value without its quotes to the string (of at least 64 bytes) passed as arg
+static void store_unquoted(int key, const char* value, size_t len, void* arg) {
+  (void)key;
+  if (len >= 2 && (value[0] == '"' || value[0] == '\'') && value[len - 1] == value[0]) {
+    value++;
+    len -= 2;
+  }
+  snprintf(arg, 64, "%.*s", (int)len, value);
+}
+
 // tries to get memory usage
 void* get_ram(void* argp) {
   if (!((struct thread_varg*)argp)->thread_flags[1]) return 0;
@@ -206,228 +961,1278 @@ void* get_ram(void* argp) {
   pclose(mem_used_fp);
   pclose(mem_total_fp);
   #else // if not _WIN32
-  char* buffer = ((struct thread_varg*)argp)->buffer;
-  FILE* meminfo;
-
     #ifdef __BSD__
+  char* buffer            = ((struct thread_varg*)argp)->buffer;
+  long long deadline      = ((struct thread_varg*)argp)->deadline;
+  char command_output[4096];
       #ifndef __OPENBSD__
-  meminfo = popen("LANG=EN_us freecolor -om 2> /dev/null", "r"); // free alternative for freebsd
+  FILE* meminfo = open_command("LANG=EN_us freecolor -om 2> /dev/null", deadline, command_output, sizeof(command_output)); // free alternative for freebsd
       #else
-  meminfo = popen("LANG=EN_us vmstat 2> /dev/null | grep -v 'procs' | grep -v 'r' | awk '{print $3 "
-                  "\" / \" $4}'",
-                  "r"); // free alternative for openbsd
+  FILE* meminfo = open_command("LANG=EN_us vmstat 2> /dev/null | grep -v 'procs' | grep -v 'r' | awk '{print $3 "
+                               "\" / \" $4}'",
+                               deadline, command_output, sizeof(command_output)); // free alternative for openbsd
       #endif
-    #else
-  // getting memory info from /proc/meminfo: https://github.com/KittyKatt/screenFetch/issues/386#issuecomment-249312716
-  meminfo = fopen("/proc/meminfo",
-                  "r"); // popen("LANG=EN_us free -m 2> /dev/null", "r"); // get ram info with free
-    #endif
   // brackets are here to restrict the access to this int variables, which are temporary
   {
-    #ifndef __OPENBSD__
+      #ifndef __OPENBSD__
     int memtotal = 0, shmem = 0, memfree = 0, buffers = 0, cached = 0, sreclaimable = 0;
-    #endif
-    while (fgets(buffer, BUFFER_SIZE, meminfo)) {
-    #ifndef __OPENBSD__
+      #endif
+    while (meminfo && fgets(buffer, BUFFER_SIZE, meminfo)) {
+      #ifndef __OPENBSD__
       sscanf(buffer, "MemTotal:       %d", &memtotal);
       sscanf(buffer, "Shmem:             %d", &shmem);
       sscanf(buffer, "MemFree:        %d", &memfree);
       sscanf(buffer, "Buffers:          %d", &buffers);
       sscanf(buffer, "Cached:          %d", &cached);
       sscanf(buffer, "SReclaimable:     %d", &sreclaimable);
-    #else
+      #else
       sscanf(buffer, "%dM / %dM", &user_info->ram_used, &user_info->ram_total);
-    #endif
+      #endif
     }
-    #ifndef __OPENBSD__
+      #ifndef __OPENBSD__
     user_info->ram_total = memtotal / 1024;
     user_info->ram_used = ((memtotal + shmem) - (memfree + buffers + cached + sreclaimable)) / 1024;
-    #endif
+      #endif
     LOG_V(user_info->ram_total);
     LOG_V(user_info->ram_used);
   }
+  if (meminfo) close_command(meminfo);
+    #else
+  // getting memory info from /proc/meminfo: https://github.com/KittyKatt/screenFetch/issues/386#issuecomment-249312716
+  static const char* const meminfo_keys[] = {"MemTotal", "Shmem", "MemFree", "Buffers", "Cached", "SReclaimable"};
+  long meminfo_values[6]                  = {0}; // kB, in the same order as the keys
+  char meminfo_buffer[8192];
+  scan_batched(((struct thread_varg*)argp)->files, "/proc/meminfo", meminfo_buffer, sizeof(meminfo_buffer), ':', meminfo_keys, 6, store_long, meminfo_values);
+  user_info->ram_total = meminfo_values[0] / 1024;
+  user_info->ram_used  = ((meminfo_values[0] + meminfo_values[1]) - (meminfo_values[2] + meminfo_values[3] + meminfo_values[4] + meminfo_values[5])) / 1024;
+  LOG_V(user_info->ram_total);
+  LOG_V(user_info->ram_used);
+    #endif
+  #endif
+#else // if __APPLE__
+  // Used
+  long long deadline = ((struct thread_varg*)argp)->deadline;
+  char mem_wired_ch[64], mem_active_ch[64], mem_compressed_ch[64];
+  run_command("vm_stat | awk '/wired/ { printf $4 }' | cut -d '.' -f 1", mem_wired_ch, sizeof(mem_wired_ch), command_timeout(deadline, -1));
+  run_command("vm_stat | awk '/active/ { printf $3 }' | cut -d '.' -f 1", mem_active_ch, sizeof(mem_active_ch), command_timeout(deadline, -1));
+  run_command("vm_stat | awk '/occupied/ { printf $5 }' | cut -d '.' -f 1", mem_compressed_ch, sizeof(mem_compressed_ch), command_timeout(deadline, -1));
+
+  int mem_wired      = atoi(mem_wired_ch);
+  int mem_active     = atoi(mem_active_ch);
+  int mem_compressed = atoi(mem_compressed_ch);
+
+  // Total
+  int64_t mem_size    = 0;
+  size_t mem_size_len = sizeof(mem_size);
+  sysctlbyname("hw.memsize", &mem_size, &mem_size_len, NULL, 0);
+  user_info->ram_used  = ((mem_wired + mem_active + mem_compressed) * 4 / 1024);
+  user_info->ram_total = mem_size / 1024 / 1024;
+  LOG_V(user_info->ram_total);
+  LOG_V(user_info->ram_used);
+#endif
+  ((struct thread_varg*)argp)->unavailable = user_info->ram_total <= 0;
+  return 0;
+}
+
+// formats a gpu name and adds it to the list
+static void add_gpu(struct info* user_info, char* name) {
+  remove_brackets(name);
+  truncate_str(name, user_info->target_width);
+  LOG_V(name);
+  info_set_gpu(user_info, user_info->gpu_count, name, strlen(name));
+}
+
+#ifdef __linux__
+static int parse_hex4(const unsigned char* p, const unsigned char* end) {
+  int value = 0;
+  for (int i = 0; i < 4; i++) {
+    if (p + i >= end) return -1;
+    int digit = p[i] >= '0' && p[i] <= '9' ? p[i] - '0' : p[i] >= 'a' && p[i] <= 'f' ? p[i] - 'a' + 10 : -1;
+    if (digit < 0) return -1;
+    value = value << 4 | digit;
+  }
+  return value;
+}
+
+static const char* pci_ids_paths[] = {"/usr/share/hwdata/pci.ids", "/usr/share/misc/pci.ids", "/usr/share/pci.ids", "/var/lib/pciutils/pci.ids"};
+
+// binary index of pci.ids, kept in the cache directory and rebuilt when pci.ids changes
+  #define PCI_INDEX_FILE "uwufetch.pci"
+  #define PCI_INDEX_MAGIC "uwupci1"
+
+struct pci_index_header {
+  char magic[8];
+  long long src_ino, src_size, src_mtime; // pci.ids the index was built from
+  uint32_t vendor_count, device_count, strings_len, reserved;
+};
+
+struct pci_index_vendor {
+  uint32_t id, name, first_device, device_count; // name is an offset in the strings
+};
+
+struct pci_index_device {
+  uint32_t id, name;
+};
+
+struct pci_index {
+  unsigned char* data; // header, sorted vendors, devices sorted by vendor and id, then the names
+  size_t len;
+  bool mapped; // mmap'd from the cache or built in memory
+  const struct pci_index_header* header;
+  const struct pci_index_vendor* vendors;
+  const struct pci_index_device* devices;
+  const char* strings;
+};
+
+static int compare_pci_id(const void* a, const void* b) { return (int)*(const uint32_t*)a - (int)*(const uint32_t*)b; }
+
+// sets the table pointers, returns false if the index does not match pci.ids or is truncated
+static bool pci_index_load(struct pci_index* index, const struct stat* src) {
+  const struct pci_index_header* header = (const void*)index->data;
+  if (index->len < sizeof(*header) || memcmp(header->magic, PCI_INDEX_MAGIC, 8) != 0 || header->src_ino != (long long)src->st_ino ||
+      header->src_size != (long long)src->st_size || header->src_mtime != (long long)src->st_mtime ||
+      index->len != sizeof(*header) + header->vendor_count * sizeof(struct pci_index_vendor) +
+                        header->device_count * sizeof(struct pci_index_device) + header->strings_len ||
+      header->strings_len == 0 || index->data[index->len - 1] != '\0')
+    return false;
+  index->header  = header;
+  index->vendors = (const void*)(index->data + sizeof(*header));
+  index->devices = (const void*)(index->vendors + header->vendor_count);
+  index->strings = (const char*)(index->devices + header->device_count);
+  return true;
+}
+
+// builds the index from the text of pci.ids: vendor lines are "vvvv  name", their devices follow as "\tdddd  name"
+static bool pci_index_build(struct pci_index* index, const unsigned char* src, size_t src_len, const struct stat* st) {
+  struct pci_index_header header = {PCI_INDEX_MAGIC, st->st_ino, st->st_size, st->st_mtime, 0, 0, 0, 0};
+  const unsigned char* end       = src + src_len;
+  for (int pass = 0; pass < 2; pass++) { // the first pass only counts, the second one fills the tables
+    struct pci_index_vendor* vendors = pass ? (void*)(index->data + sizeof(header)) : NULL;
+    struct pci_index_device* devices = pass ? (void*)(vendors + header.vendor_count) : NULL;
+    char* strings                    = pass ? (char*)(devices + header.device_count) : NULL;
+    uint32_t vendor_count = 0, device_count = 0, strings_len = 0;
+    bool in_vendor = false;
+    for (const unsigned char *line = src, *eol; line < end; line = eol + 1) {
+      if (!(eol = memchr(line, '\n', end - line))) eol = end;
+      if (line[0] == '#' || eol - line < 7) continue;
+      if (line[0] == 'C' && line[1] == ' ') break; // the device classes list comes after all the vendors
+      int id;
+      const unsigned char* name;
+      if (line[0] != '\t' && (id = parse_hex4(line, eol)) >= 0) {
+        name = line + 6;
+        if (pass) vendors[vendor_count] = (struct pci_index_vendor){id, strings_len, device_count, 0};
+        vendor_count++;
+        in_vendor = true;
+      } else if (in_vendor && line[1] != '\t' && (id = parse_hex4(line + 1, eol)) >= 0) {
+        name = line + 7;
+        if (pass) {
+          devices[device_count] = (struct pci_index_device){id, strings_len};
+          vendors[vendor_count - 1].device_count++;
+        }
+        device_count++;
+      } else
+        continue;
+      if (pass) {
+        memcpy(strings + strings_len, name, eol - name);
+        strings[strings_len + (eol - name)] = '\0';
+      }
+      strings_len += eol - name + 1;
+    }
+    if (pass) {
+      for (uint32_t i = 0; i < vendor_count; i++)
+        qsort(devices + vendors[i].first_device, vendors[i].device_count, sizeof(*devices), compare_pci_id);
+      qsort(vendors, vendor_count, sizeof(*vendors), compare_pci_id);
+    } else {
+      header.vendor_count = vendor_count;
+      header.device_count = device_count;
+      header.strings_len  = strings_len;
+      index->len          = sizeof(header) + vendor_count * sizeof(*vendors) + device_count * sizeof(*devices) + strings_len;
+      if (!strings_len || !(index->data = malloc(index->len))) return false;
+      memcpy(index->data, &header, sizeof(header));
+    }
+  }
+  return pci_index_load(index, st);
+}
+
+static void pci_index_close(struct pci_index* index) {
+  if (index->mapped)
+    munmap(index->data, index->len);
+  else
+    free(index->data);
+  index->data = NULL;
+}
+
+// maps the pci.ids index, building it (and saving it for the next runs) if it is missing or outdated
+static bool pci_index_open(struct pci_index* index) {
+  memset(index, 0, sizeof(*index));
+  struct stat st;
+  const char* src_path = NULL;
+  for (size_t i = 0; i < sizeof(pci_ids_paths) / sizeof(pci_ids_paths[0]) && !src_path; i++)
+    if (stat(pci_ids_paths[i], &st) == 0) src_path = pci_ids_paths[i];
+  if (!src_path) return false;
+  char cache_file[PATH_MAX];
+  bool cacheable = get_cache_path(PCI_INDEX_FILE, cache_file, sizeof(cache_file));
+  if (cacheable && map_file(cache_file, (const unsigned char**)&index->data, &index->len) == 0 && index->data) {
+    index->mapped = true;
+    if (pci_index_load(index, &st)) return true;
+    pci_index_close(index);
+  }
+  LOG_I("building the pci.ids index from %s", src_path);
+  const unsigned char* src;
+  size_t src_len;
+  if (map_file(src_path, &src, &src_len) != 0 || !src) return false;
+  index->mapped = false;
+  bool built    = pci_index_build(index, src, src_len, &st);
+  munmap((void*)src, src_len);
+  if (!built) {
+    pci_index_close(index);
+    return false;
+  }
+  if (cacheable) { // written to a temporary file first, so a concurrent run never maps half of it
+    char tmp_file[PATH_MAX + 16];
+    FILE* index_fp = create_temp(cache_file, tmp_file, sizeof(tmp_file));
+    if (index_fp) {
+      if (fwrite(index->data, 1, index->len, index_fp) != index->len || fclose(index_fp) != 0 || rename(tmp_file, cache_file) != 0)
+        remove(tmp_file);
+    } else {
+      LOG_E("Failed to write to %.1024s!", cache_file); // bounded, the log line is shorter than a path can be
+    }
+  }
+  return true;
+}
+
+// looks up the vendor and device names with a binary search in the index, returns false if the vendor is not listed
+static bool pci_lookup(const struct pci_index* index, int vendor, int device, char* vendor_name, char* device_name, size_t len) {
+  uint32_t vendor_id = vendor, device_id = device;
+  const struct pci_index_vendor* found_vendor = bsearch(&vendor_id, index->vendors, index->header->vendor_count, sizeof(*index->vendors), compare_pci_id);
+  if (!found_vendor || found_vendor->name >= index->header->strings_len ||
+      (size_t)found_vendor->first_device + found_vendor->device_count > index->header->device_count)
+    return false;
+  snprintf(vendor_name, len, "%s", index->strings + found_vendor->name);
+  const struct pci_index_device* found_device = bsearch(&device_id, index->devices + found_vendor->first_device, found_vendor->device_count,
+                                                        sizeof(*index->devices), compare_pci_id);
+  if (found_device && found_device->name < index->header->strings_len) snprintf(device_name, len, "%s", index->strings + found_device->name);
+  return true;
+}
+
+struct pci_gpu {
+  char slot[16]; // pci address, sorting by it keeps the gpu order stable
+  int vendor, device, count;
+};
+
+static int compare_pci_gpu(const void* a, const void* b) { return strcmp(((struct pci_gpu*)a)->slot, ((struct pci_gpu*)b)->slot); }
+
+// lists the display controllers (pci class 0x03) known to the kernel, grouping identical cards
+static int get_gpus_sysfs(struct info* user_info) {
+  int pci_fd = open("/sys/bus/pci/devices", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (pci_fd < 0) return 0;
+  DIR* pci_dir = fdopendir(pci_fd);
+  if (!pci_dir) {
+    close(pci_fd);
+    return 0;
+  }
+  struct pci_gpu gpus[MAX_GPUS];
+  int gpu_count = 0;
+  struct dirent* entry;
+  while ((entry = readdir(pci_dir)) && gpu_count < MAX_GPUS) {
+    char path[300], value[16];
+    if (entry->d_name[0] == '.' || strlen(entry->d_name) >= sizeof(gpus[0].slot)) continue;
+    snprintf(path, sizeof(path), "%s/class", entry->d_name);
+    if (read_small_file(pci_fd, path, value, sizeof(value)) < 4 || strncmp(value, "0x03", 4) != 0) continue;
+    struct pci_gpu* gpu = &gpus[gpu_count];
+    snprintf(path, sizeof(path), "%s/vendor", entry->d_name);
+    if (read_small_file(pci_fd, path, value, sizeof(value)) != 6 || (gpu->vendor = parse_hex4((unsigned char*)value + 2, (unsigned char*)value + 6)) < 0) continue;
+    snprintf(path, sizeof(path), "%s/device", entry->d_name);
+    if (read_small_file(pci_fd, path, value, sizeof(value)) != 6 || (gpu->device = parse_hex4((unsigned char*)value + 2, (unsigned char*)value + 6)) < 0) continue;
+    memcpy(gpu->slot, entry->d_name, strlen(entry->d_name) + 1); // its length was checked above
+    gpu->count = 1;
+    gpu_count++;
+  }
+  closedir(pci_dir);
+  qsort(gpus, gpu_count, sizeof(struct pci_gpu), compare_pci_gpu);
+
+  int gpuc = 0;
+  struct pci_index index;
+  bool have_index = gpu_count && pci_index_open(&index);
+  for (int i = 0; i < gpu_count; i++) {
+    int j = 0;
+    while (j < gpuc && (gpus[j].vendor != gpus[i].vendor || gpus[j].device != gpus[i].device)) j++;
+    if (j < gpuc) {
+      gpus[j].count++;
+      continue;
+    }
+    gpus[gpuc++] = gpus[i];
+  }
+  for (int i = 0; i < gpuc; i++) {
+    char vendor_name[128], device_name[128], gpu_name[sizeof(vendor_name) + sizeof(device_name) + 16]; // room for "<count>x " too
+    snprintf(vendor_name, sizeof(vendor_name), "Vendor %04x", gpus[i].vendor);
+    snprintf(device_name, sizeof(device_name), "Device %04x", gpus[i].device); // same as lspci for unknown ids
+    if (have_index) pci_lookup(&index, gpus[i].vendor, gpus[i].device, vendor_name, device_name, sizeof(vendor_name));
+    if (gpus[i].count > 1)
+      snprintf(gpu_name, sizeof(gpu_name), "%dx %s %s", gpus[i].count, vendor_name, device_name);
+    else
+      snprintf(gpu_name, sizeof(gpu_name), "%s %s", vendor_name, device_name);
+    add_gpu(user_info, gpu_name);
+  }
+  if (have_index) pci_index_close(&index);
+  return user_info->gpu_count;
+}
+#endif // __linux__
+
+// tries to get installed gpu(s)
+void* get_gpu(void* argp) {
+  if (!((struct thread_varg*)argp)->thread_flags[2]) return 0;
+  LOG_I("getting gpu(s)");
+  char* buffer           = ((struct thread_varg*)argp)->buffer;
+  struct info* user_info = ((struct thread_varg*)argp)->user_info;
+  char gpu_name[BUFFER_SIZE];
+  int gpuc  = 0; // gpu counter
+  FILE* gpu = NULL;
+#ifndef _WIN32
+  long long deadline = ((struct thread_varg*)argp)->deadline;
+  char command_output[16384];
+#endif
+#ifdef __linux__
+  gpuc = get_gpus_sysfs(user_info); // nothing has to be run if the kernel already lists them
+#endif
+#ifndef _WIN32
+  if (gpuc == 0) {
+    LOG_I("getting gpus with lshw");
+    gpu = open_command("LANG=en_US lshw -class display 2> /dev/null", deadline, command_output, sizeof(command_output)); // force language to english
+
+    // add all gpus to the list
+    while (gpu && fgets(buffer, BUFFER_SIZE, gpu))
+      if (sscanf(buffer, "    product: %255[^\n]", gpu_name) == 1) add_gpu(user_info, gpu_name);
+    gpuc = user_info->gpu_count;
+  }
+#endif
+
+  if (gpuc == 0 || strlen(info_gpu(user_info, 0)) < 2) {
+    if (gpu) close_command(gpu);
+    gpu = NULL;
+    // get gpus with lspci command
+    if (strcmp(user_info->os_name, "android") != 0) {
+#ifndef __APPLE__
+  #ifdef _WIN32
+      gpu = popen("wmic PATH Win32_VideoController GET Name", "r");
+  #else
+      gpu = open_command("lspci -mm 2> /dev/null | grep \"VGA\" | awk -F '\"' '{print $4 $5 $6}'", deadline, command_output, sizeof(command_output));
+  #endif
+#else
+      gpu = open_command("system_profiler SPDisplaysDataType | awk -F ': ' '/Chipset Model: /{ print $2 }'", deadline, command_output,
+                         sizeof(command_output));
+#endif
+    } else
+#ifndef _WIN32
+      gpu = open_command("getprop ro.hardware.vulkan 2> /dev/null", deadline, command_output, sizeof(command_output)); // for android
+#endif
+  }
+
+  // get all the gpus
+  while (gpu && fgets(buffer, BUFFER_SIZE, gpu)) {
+    // windows
+    if (strstr(buffer, "Name") || (strlen(buffer) == 2))
+      continue;
+    else if (sscanf(buffer, "%255[^\n]", gpu_name) == 1)
+      add_gpu(user_info, gpu_name);
+  }
+  if (gpu) close_command(gpu);
+  return 0;
+}
+
+#ifndef _WIN32
+  #ifdef __linux__
+// refresh rate of the preferred timing in the edid, if it matches the given mode
+static int edid_refresh_rate(const unsigned char* edid, int len, int width, int height) {
+  if (len < 72) return 0;
+  const unsigned char* timing = edid + 54; // first detailed timing descriptor
+  long clock                  = (timing[0] | timing[1] << 8) * 10000L;
+  int h_active = timing[2] | (timing[4] & 0xf0) << 4, h_blank = timing[3] | (timing[4] & 0x0f) << 8;
+  int v_active = timing[5] | (timing[7] & 0xf0) << 4, v_blank = timing[6] | (timing[7] & 0x0f) << 8;
+  if (!clock || h_active != width || v_active != height) return 0;
+  long total = (long)(h_active + h_blank) * (v_active + v_blank);
+  return (clock + total / 2) / total;
+}
+
+static int compare_name(const void* a, const void* b) { return strcmp((const char*)a, (const char*)b); }
+
+// lists the connected monitors from the drm connectors, their first mode is the preferred one
+static int get_res_drm(struct info* user_info) {
+  int drm_fd = open("/sys/class/drm", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (drm_fd < 0) return 0;
+  DIR* drm_dir = fdopendir(drm_fd);
+  if (!drm_dir) {
+    close(drm_fd);
+    return 0;
+  }
+  char connectors[MAX_MONITORS * 4][64];
+  int connector_count = 0;
+  struct dirent* entry;
+  while ((entry = readdir(drm_dir)) && connector_count < MAX_MONITORS * 4)
+    if (strncmp(entry->d_name, "card", 4) == 0 && strchr(entry->d_name, '-') && strlen(entry->d_name) < 64) // cardN-<connector>
+      strcpy(connectors[connector_count++], entry->d_name);
+  qsort(connectors, connector_count, sizeof(connectors[0]), compare_name);
+
+  for (int i = 0; i < connector_count && user_info->monitor_count < MAX_MONITORS; i++) {
+    char path[sizeof(connectors[0]) + 16], value[64]; // <connector>/<attribute>
+    char* attribute = path + snprintf(path, sizeof(path), "%.63s/", connectors[i]);
+    strcpy(attribute, "status");
+    if (read_small_file(drm_fd, path, value, sizeof(value)) < 0 || strcmp(value, "connected") != 0) continue;
+    strcpy(attribute, "enabled");
+    if (read_small_file(drm_fd, path, value, sizeof(value)) > 0 && strcmp(value, "disabled") == 0) continue; // e.g. closed laptop lid
+    struct monitor* monitor = &user_info->monitors[user_info->monitor_count];
+    strcpy(attribute, "modes");
+    if (read_small_file(drm_fd, path, value, sizeof(value)) < 0 || sscanf(value, "%dx%d", &monitor->width, &monitor->height) != 2) continue;
+    unsigned char edid[128];
+    strcpy(attribute, "edid");
+    int edid_fd = openat(drm_fd, path, O_RDONLY | O_CLOEXEC);
+    if (edid_fd >= 0) {
+      monitor->refresh_rate = edid_refresh_rate(edid, read(edid_fd, edid, sizeof(edid)), monitor->width, monitor->height);
+      close(edid_fd);
+    }
+    LOG_I("%.*s: %dx%d@%dHz", (int)(attribute - path - 1), path, monitor->width, monitor->height, monitor->refresh_rate);
+    user_info->monitor_count++;
+  }
+  closedir(drm_dir);
+  return user_info->monitor_count;
+}
+  #endif // __linux__
+
+  #define X11_TIMEOUT 250 // milliseconds the x server has to answer
+
+static bool read_full(int fd, void* buffer, size_t len, long long deadline) {
+  for (size_t done = 0; done < len;) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    long long left    = deadline - now_ms();
+    if (left <= 0 || poll(&pfd, 1, left) <= 0) return false;
+    ssize_t n = read(fd, (char*)buffer + done, len - done);
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+static bool write_full(int fd, const void* buffer, size_t len, long long deadline) {
+  for (size_t done = 0; done < len;) {
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    long long left    = deadline - now_ms();
+    if (left <= 0 || poll(&pfd, 1, left) <= 0) return false;
+    ssize_t n = write(fd, (const char*)buffer + done, len - done);
+    if (n < 0 && errno != EAGAIN) return false;
+    if (n > 0) done += n;
+  }
+  return true;
+}
+
+// connects a non-blocking socket, a server whose backlog is full (EAGAIN) is not waited for
+static bool connect_until(int fd, const struct sockaddr* addr, socklen_t len, long long deadline) {
+  if (connect(fd, addr, len) == 0) return true;
+  if (errno != EINPROGRESS) return false;
+  struct pollfd pfd   = {fd, POLLOUT, 0};
+  long long left      = deadline - now_ms();
+  int error           = 0;
+  socklen_t error_len = sizeof(error);
+  return left > 0 && poll(&pfd, 1, left) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_len) == 0 && !error;
+}
+
+// finds the MIT-MAGIC-COOKIE-1 of a local display in the xauthority file, returns its length or 0
+static int read_xauth(int display_number, unsigned char* cookie, int len) {
+  char path[PATH_MAX], hostname[256] = "", number[16];
+  if (getenv("XAUTHORITY"))
+    snprintf(path, sizeof(path), "%s", getenv("XAUTHORITY"));
+  else if (!expand_home("~/.Xauthority", path, sizeof(path)))
+    return 0;
+  gethostname(hostname, sizeof(hostname) - 1);
+  snprintf(number, sizeof(number), "%d", display_number);
+  const unsigned char* map;
+  size_t map_len;
+  if (map_file(path, &map, &map_len) != 0 || !map) return 0;
+  int cookie_len           = 0;
+  const unsigned char* end = map + map_len;
+  for (const unsigned char* p = map; p + 2 <= end && !cookie_len;) {
+    // family, then address, display number, auth name and auth data, each one prefixed by its length
+    int family = read_be16(p);
+    const unsigned char* fields[4];
+    int lens[4];
+    p += 2;
+    for (int i = 0; i < 4; i++) {
+      if (p + 2 > end || p + 2 + read_be16(p) > end) goto done;
+      lens[i]   = read_be16(p);
+      fields[i] = p + 2;
+      p += 2 + lens[i];
+    }
+    bool local = family == 0xffff || (family == 256 && lens[0] == (int)strlen(hostname) && memcmp(fields[0], hostname, lens[0]) == 0);
+    if (local && (lens[1] == 0 || (lens[1] == (int)strlen(number) && memcmp(fields[1], number, lens[1]) == 0)) &&
+        lens[2] == 18 && memcmp(fields[2], "MIT-MAGIC-COOKIE-1", 18) == 0 && lens[3] <= len) {
+      memcpy(cookie, fields[3], lens[3]);
+      cookie_len = lens[3];
+    }
+  }
+done:
+  munmap((void*)map, map_len);
+  return cookie_len;
+}
+
+// reads the screen sizes from the setup reply of the local x server, the same values xwininfo -root prints
+static int get_res_x11(struct info* user_info) {
+  const char* display = getenv("DISPLAY");
+  const char* colon   = display ? strrchr(display, ':') : NULL;
+  if (!colon || (colon != display && strncmp(display, "unix:", 5) != 0)) return 0; // remote displays are not queried
+  int display_number      = atoi(colon + 1);
+  struct sockaddr_un addr = {0};
+  addr.sun_family         = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "/tmp/.X11-unix/X%d", display_number);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return 0;
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  fcntl(fd, F_SETFL, O_NONBLOCK); // a hung server must not block the collector past X11_TIMEOUT
+  long long deadline = now_ms() + X11_TIMEOUT;
+  if (!connect_until(fd, (struct sockaddr*)&addr, sizeof(addr), deadline)) {
+  #ifdef __linux__ // the socket could be in the abstract namespace only
+    memmove(addr.sun_path + 1, addr.sun_path, sizeof(addr.sun_path) - 1);
+    addr.sun_path[0] = '\0';
+    if (!connect_until(fd, (struct sockaddr*)&addr, offsetof(struct sockaddr_un, sun_path) + 1 + strlen(addr.sun_path + 1), deadline))
+  #endif
+    {
+      close(fd);
+      return 0;
+    }
+  }
+
+  // connection setup, sent in our byte order so that the server answers in it too
+  unsigned char request[12 + 20 + 256] = {0}, cookie[256];
+  uint16_t cookie_len = read_xauth(display_number, cookie, sizeof(cookie)), name_len = cookie_len ? 18 : 0, major = 11;
+  uint16_t one        = 1;
+  request[0]          = *(unsigned char*)&one ? 'l' : 'B';
+  memcpy(request + 2, &major, 2);
+  memcpy(request + 6, &name_len, 2);
+  memcpy(request + 8, &cookie_len, 2);
+  memcpy(request + 12, "MIT-MAGIC-COOKIE-1", name_len);
+  memcpy(request + 12 + 20, cookie, cookie_len);
+  size_t request_len = 12 + 20 + ((cookie_len + 3) & ~3);
+  unsigned char header[8];
+  uint16_t reply_words;
+  unsigned char* reply = NULL;
+  if (write_full(fd, request, request_len, deadline) && read_full(fd, header, 8, deadline) && header[0] == 1) {
+    memcpy(&reply_words, header + 6, 2);
+    // the fixed part of the reply after the header is 32 bytes, anything shorter is not a real setup reply
+    if (reply_words * 4 >= 32 && (reply = malloc(reply_words * 4)) && !read_full(fd, reply, reply_words * 4, deadline)) {
+      free(reply);
+      reply = NULL;
+    }
+  }
+  close(fd);
+  if (!reply) {
+    LOG_E("x server setup failed");
+    return 0;
+  }
+
+  // every offset is checked against the received length before it is read, the lengths in the reply are not trusted
+  uint16_t vendor_len;
+  size_t reply_len = reply_words * 4;
+  memcpy(&vendor_len, reply + 16, 2);
+  size_t screen = 32 + ((vendor_len + 3) & ~3) + reply[21] * 8; // after the vendor and the pixmap formats
+  for (int i = 0; i < reply[20] && screen + 40 <= reply_len && user_info->monitor_count < MAX_MONITORS; i++) {
+    struct monitor* monitor = &user_info->monitors[user_info->monitor_count++];
+    uint16_t width, height;
+    memcpy(&width, reply + screen + 20, 2);
+    memcpy(&height, reply + screen + 22, 2);
+    monitor->width  = width;
+    monitor->height = height;
+    int depths      = reply[screen + 39];
+    for (screen += 40; depths > 0 && screen + 8 <= reply_len; depths--) { // skip the allowed depths and their visuals
+      uint16_t visuals;
+      memcpy(&visuals, reply + screen + 2, 2);
+      screen += 8 + visuals * 24;
+    }
+  }
+  free(reply);
+  return user_info->monitor_count;
+}
+#endif // _WIN32
+
+// tries to get screen resolution
+#ifndef _WIN32
+void* get_res(void* argp) {
+  if (!((struct thread_varg*)argp)->thread_flags[3]) return 0;
+  LOG_I("getting resolution");
+  struct info* user_info = ((struct thread_varg*)argp)->user_info;
+  #ifdef __linux__
+  if (!get_res_drm(user_info)) // drm lists every monitor, even on wayland or without a display server
+  #endif
+    get_res_x11(user_info);
+  if (user_info->monitor_count) {
+    user_info->screen_width  = user_info->monitors[0].width;
+    user_info->screen_height = user_info->monitors[0].height;
+  }
+  LOG_V(user_info->monitor_count);
+  LOG_V(user_info->screen_width);
+  LOG_V(user_info->screen_height);
+  ((struct thread_varg*)argp)->unavailable = !user_info->screen_width; // no monitor, or no way to list them
+#else
+void* get_res() {
+  // TODO: get resolution on windows
+#endif
+  return 0;
+}
+
+#ifndef _WIN32
+  #ifndef __APPLE__
+// counts the lines starting with prefix (ignoring indentation) and ending with suffix, if given
+static int count_lines(const char* path, const char* prefix, const char* suffix) {
+  const unsigned char* map;
+  size_t len;
+  if (map_file(path, &map, &len) != 0) return -1;
+  size_t prefix_len = strlen(prefix), suffix_len = suffix ? strlen(suffix) : 0;
+  int count               = 0;
+  const unsigned char* end = map + len;
+  for (const unsigned char* line = map; line < end;) {
+    // memchr is vectorized by every libc, so most of the file is skipped a whole register at a time
+    const unsigned char* eol = memchr(line, '\n', end - line);
+    if (!eol) eol = end;
+    while (line < eol && (*line == ' ' || *line == '\t')) line++;
+    if ((size_t)(eol - line) >= prefix_len + suffix_len && memcmp(line, prefix, prefix_len) == 0 &&
+        (!suffix || memcmp(eol - suffix_len, suffix, suffix_len) == 0))
+      count++;
+    line = eol + 1;
+  }
+  if (map) munmap((void*)map, len);
+  return count;
+}
+  #endif // __APPLE__
+
+// counts the directories found depth levels below path, skipping hidden and temporary ones
+static int count_dirs(int parent_fd, const char* path, int depth) {
+  int fd = openat(parent_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  DIR* dir = fdopendir(fd);
+  if (!dir) {
+    close(fd);
+    return -1;
+  }
+  int count = 0;
+  struct dirent* entry;
+  while ((entry = readdir(dir))) {
+    if (entry->d_name[0] == '.' || entry->d_name[0] == '-') continue; // '-MERGING-' dirs are left by interrupted emerges
+    if (entry->d_type == DT_UNKNOWN) {
+      struct stat st;
+      if (fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) continue;
+    } else if (entry->d_type != DT_DIR)
+      continue;
+    if (depth > 1) {
+      int sub_count = count_dirs(fd, entry->d_name, depth - 1);
+      if (sub_count > 0) count += sub_count;
+    } else
+      count++;
+  }
+  closedir(dir);
+  return count;
+}
+
+// minimal read-only sqlite reader, just enough to walk table b-trees without linking libsqlite3
+struct sqlite_db {
+  const unsigned char *map, *wal; // database file and its write-ahead log
+  size_t len, wal_len;
+  size_t* wal_pages; // page number -> offset of its newest committed copy in the wal (0 if there is none)
+  uint32_t page_size, usable_size, page_count;
+};
+
+struct sqlite_value {
+  int64_t integer;
+  const unsigned char* text; // text and blob columns
+  size_t text_len;
+};
+
+// decodes a sqlite varint, returns the number of bytes read or 0 if it runs past end
+static int read_varint(const unsigned char* p, const unsigned char* end, int64_t* value) {
+  uint64_t v = 0;
+  for (int i = 0; i < 9; i++) {
+    if (p + i >= end) return 0;
+    if (i == 8) {
+      *value = (int64_t)(v << 8 | p[i]);
+      return 9;
+    }
+    v = v << 7 | (p[i] & 0x7f);
+    if (!(p[i] & 0x80)) {
+      *value = (int64_t)v;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+static void wal_checksum(bool big_endian, const unsigned char* p, size_t len, uint32_t* s0, uint32_t* s1) {
+  for (size_t i = 0; i + 8 <= len; i += 8) {
+    uint32_t x0 = big_endian ? read_be32(p + i) : (uint32_t)p[i + 3] << 24 | p[i + 2] << 16 | p[i + 1] << 8 | p[i];
+    uint32_t x1 = big_endian ? read_be32(p + i + 4) : (uint32_t)p[i + 7] << 24 | p[i + 6] << 16 | p[i + 5] << 8 | p[i + 4];
+    *s0 += x0 + *s1;
+    *s1 += x1 + *s0;
+  }
+}
+
+// indexes the pages committed to the write-ahead log, they are newer than the ones in the database file
+static void sqlite_load_wal(struct sqlite_db* db) {
+  const unsigned char* wal = db->wal;
+  uint32_t magic           = read_be32(wal);
+  if ((magic & 0xfffffffe) != 0x377f0682 || read_be32(wal + 8) != db->page_size) return;
+  uint32_t s0 = 0, s1 = 0;
+  wal_checksum(magic & 1, wal, 24, &s0, &s1);
+  if (s0 != read_be32(wal + 24) || s1 != read_be32(wal + 28)) return;
+  size_t frame_size = 24 + db->page_size, last_commit = 0;
+  uint32_t page_count = 0;
+  for (size_t off = 32; off + frame_size <= db->wal_len; off += frame_size) {
+    const unsigned char* frame = wal + off;
+    if (memcmp(frame + 8, wal + 16, 8) != 0) break; // salts from an older generation of the log
+    wal_checksum(magic & 1, frame, 8, &s0, &s1);
+    wal_checksum(magic & 1, frame + 24, db->page_size, &s0, &s1);
+    if (s0 != read_be32(frame + 16) || s1 != read_be32(frame + 20)) break; // torn write
+    if (read_be32(frame + 4)) {                                          // commit frame
+      last_commit = off + frame_size;
+      page_count  = read_be32(frame + 4);
+    }
+  }
+  if (!last_commit || !(db->wal_pages = calloc(page_count + 1, sizeof(size_t)))) return;
+  for (size_t off = 32; off < last_commit; off += frame_size) {
+    uint32_t page = read_be32(wal + off);
+    if (page && page <= page_count) db->wal_pages[page] = off + 24;
+  }
+  db->page_count = page_count;
+}
+
+static void sqlite_close(struct sqlite_db* db) {
+  if (db->map) munmap((void*)db->map, db->len);
+  if (db->wal) munmap((void*)db->wal, db->wal_len);
+  free(db->wal_pages);
+}
+
+static int sqlite_open(struct sqlite_db* db, const char* path) {
+  memset(db, 0, sizeof(*db));
+  if (map_file(path, &db->map, &db->len) != 0) return -1;
+  if (db->len < 100 || memcmp(db->map, "SQLite format 3", 16) != 0) {
+    sqlite_close(db);
+    return -1;
+  }
+  db->page_size   = read_be16(db->map + 16) == 1 ? 65536 : read_be16(db->map + 16);
+  db->usable_size = db->page_size - db->map[20];
+  db->page_count  = db->len / db->page_size;
+  char wal_path[PATH_MAX];
+  snprintf(wal_path, sizeof(wal_path), "%s-wal", path);
+  if (map_file(wal_path, &db->wal, &db->wal_len) == 0 && db->wal_len >= 32) sqlite_load_wal(db);
+  return 0;
+}
+
+static const unsigned char* sqlite_page(const struct sqlite_db* db, uint32_t page) {
+  if (page == 0 || page > db->page_count) return NULL;
+  if (db->wal_pages && db->wal_pages[page]) return db->wal + db->wal_pages[page];
+  if ((size_t)page * db->page_size > db->len) return NULL;
+  return db->map + (size_t)(page - 1) * db->page_size;
+}
+
+// bytes of a payload stored in the b-tree cell itself, the rest lives in overflow pages
+static size_t sqlite_local_payload(const struct sqlite_db* db, size_t payload) {
+  size_t max_local = db->usable_size - 35;
+  if (payload <= max_local) return payload;
+  size_t min_local = (db->usable_size - 12) * 32 / 255 - 23;
+  size_t local     = min_local + (payload - min_local) % (db->usable_size - 4);
+  return local <= max_local ? local : min_local;
+}
+
+// reads column col of a record, returns false if it can't be found
+static bool sqlite_column(const unsigned char* record, size_t len, int col, struct sqlite_value* value) {
+  const unsigned char* end = record + len;
+  int64_t header_len;
+  int n = read_varint(record, end, &header_len);
+  if (!n || header_len < n || (size_t)header_len > len) return false;
+  const unsigned char *type_p = record + n, *data = record + header_len;
+  for (int i = 0; type_p < record + header_len; i++) {
+    int64_t type;
+    if (!(n = read_varint(type_p, record + header_len, &type))) return false;
+    type_p += n;
+    size_t size = type >= 12 ? (type - 12) / 2 : type < 5 ? type : type == 5 ? 6 : type < 8 ? 8 : 0;
+    if (data + size > end) return false;
+    if (i == col) {
+      memset(value, 0, sizeof(*value));
+      if (type >= 12) {
+        value->text     = data;
+        value->text_len = size;
+      } else if (type == 8 || type == 9)
+        value->integer = type - 8;
+      else if (type != 7) {
+        uint64_t integer = size && data[0] & 0x80 ? UINT64_MAX : 0; // sign extension
+        for (size_t j = 0; j < size; j++) integer = integer << 8 | data[j];
+        value->integer = (int64_t)integer;
+      }
+      return true;
+    }
+    data += size;
+  }
+  return false;
+}
+
+// calls row_fn on every row of the table b-tree rooted at root, returns the number of rows or -1 on errors
+static int sqlite_walk(const struct sqlite_db* db, uint32_t root, void (*row_fn)(void*, int64_t, const unsigned char*, size_t), void* arg, int depth) {
+  const unsigned char* page = sqlite_page(db, root);
+  if (!page || depth > 32) return -1; // missing page or cyclic (corrupted) tree
+  const unsigned char *header = page + (root == 1 ? 100 : 0), *end = page + db->page_size;
+  int cells                   = read_be16(header + 3);
+  if (header[0] == 0x0d) { // leaf page
+    for (int i = 0; row_fn && i < cells; i++) {
+      size_t cell_off = read_be16(header + 8 + 2 * i);
+      if (cell_off >= db->page_size) return -1;
+      const unsigned char* cell = page + cell_off;
+      int64_t payload, rowid;
+      int n = read_varint(cell, end, &payload);
+      if (!n) return -1;
+      cell += n;
+      if (!(n = read_varint(cell, end, &rowid))) return -1;
+      cell += n;
+      size_t local = sqlite_local_payload(db, payload);
+      if (cell + local > end) return -1;
+      row_fn(arg, rowid, cell, local);
+    }
+    return cells;
+  }
+  if (header[0] != 0x05) return -1; // not a table b-tree
+  int rows = 0;
+  for (int i = 0; i <= cells; i++) {
+    size_t cell_off = i < cells ? read_be16(header + 12 + 2 * i) : 0;
+    if (cell_off + 4 > db->page_size) return -1;
+    int child_rows = sqlite_walk(db, i < cells ? read_be32(page + cell_off) : read_be32(header + 8), row_fn, arg, depth + 1);
+    if (child_rows < 0) return -1;
+    rows += child_rows;
+  }
+  return rows;
+}
+
+struct sqlite_table {
+  const char* name;
+  uint32_t root;
+};
+
+// looks for a table in the sqlite_schema rows
+static void sqlite_find_table(void* arg, int64_t rowid, const unsigned char* record, size_t len) {
+  (void)rowid;
+  struct sqlite_table* table = arg;
+  struct sqlite_value type, name, root;
+  size_t name_len = strlen(table->name);
+  if (sqlite_column(record, len, 0, &type) && type.text_len == 5 && memcmp(type.text, "table", 5) == 0 &&
+      sqlite_column(record, len, 1, &name) && name.text_len == name_len && memcmp(name.text, table->name, name_len) == 0 &&
+      sqlite_column(record, len, 3, &root))
+    table->root = root.integer;
+}
+
+static uint32_t sqlite_table_root(const struct sqlite_db* db, const char* name) {
+  struct sqlite_table table = {name, 0};
+  if (sqlite_walk(db, 1, sqlite_find_table, &table, 0) < 0) return 0;
+  return table.root;
+}
+
+static int sqlite_count_rows(const char* path, const char* table) {
+  struct sqlite_db db;
+  if (sqlite_open(&db, path) != 0) return -1;
+  uint32_t root = sqlite_table_root(&db, table);
+  int count     = root ? sqlite_walk(&db, root, NULL, NULL, 0) : -1;
+  sqlite_close(&db);
+  return count;
+}
+
+// native package database readers, used instead of the package manager commands when possible
+  #ifndef __APPLE__
+static int count_dpkg(const char* path) { return count_lines(path, "Status: ", " installed"); }
+static int count_apk(const char* path) { return count_lines(path, "P:", NULL); }
+static int count_xbps(const char* path) { return count_lines(path, "<key>pkgver</key>", NULL); }
+static int count_pacman(const char* path) { return count_dirs(AT_FDCWD, path, 1); }
+    #ifdef __OPENBSD__
+static int count_pkg_info(const char* path) { return count_dirs(AT_FDCWD, path, 1); }
+    #else
+static int count_portage(const char* path) { return count_dirs(AT_FDCWD, path, 2); } // category/package
+    #endif
+static int count_rpm(const char* path) { return sqlite_count_rows(path, "Packages"); }
+static int count_pkgng(const char* path) { return sqlite_count_rows(path, "packages"); }
+  #endif // __APPLE__
+static int count_macports(const char* path) { return sqlite_count_rows(path, "ports"); }
+
+// flatpak installs apps and runtimes as <kind>/<name>/<arch>/<branch>, in the system or in the user installation
+static int count_flatpak(const char* path) {
+  char installation[PATH_MAX];
+  const char* kinds[] = {"app", "runtime"};
+  int count           = -1;
+  int fd              = expand_home(path, installation, sizeof(installation)) ? open(installation, O_RDONLY | O_DIRECTORY | O_CLOEXEC) : -1;
+  if (fd < 0) return -1;
+  for (int i = 0; i < 2; i++) {
+    int refs = count_dirs(fd, kinds[i], 3); // the "current" links at the arch level are not counted
+    if (refs >= 0) count = (count < 0 ? 0 : count) + refs;
+  }
+  close(fd);
+  return count;
+}
+
+static int compare_str(const void* a, const void* b) { return strcmp(*(char* const*)a, *(char* const*)b); }
+
+// snapd keeps every revision of a snap as <name>_<revision>.snap, so only distinct names are counted
+static int count_snap(const char* path) {
+  DIR* dir = opendir(path);
+  if (!dir) return -1;
+  char* names[1024];
+  int name_count = 0, count = 0;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) && name_count < 1024) {
+    char* revision = strrchr(entry->d_name, '_');
+    size_t len     = strlen(entry->d_name);
+    if (!revision || len < 5 || strcmp(entry->d_name + len - 5, ".snap") != 0) continue;
+    if ((names[name_count] = strndup(entry->d_name, revision - entry->d_name))) name_count++;
+  }
+  closedir(dir);
+  qsort(names, name_count, sizeof(char*), compare_str);
+  for (int i = 0; i < name_count; i++) {
+    if (i == 0 || strcmp(names[i], names[i - 1]) != 0) count++;
+    if (i > 0) free(names[i - 1]);
+  }
+  if (name_count) free(names[name_count - 1]);
+  return count;
+}
+
+// counts the entries of the guix manifest "packages" list, propagated inputs are nested deeper and are not counted
+static int count_guix(const char* path) {
+  char manifest_path[PATH_MAX];
+  if (!expand_home(path, manifest_path, sizeof(manifest_path))) return -1;
+  const unsigned char* map;
+  size_t len;
+  if (map_file(manifest_path, &map, &len) != 0) return -1;
+  const unsigned char *end = map + len, *p = map ? memmem(map, len, "(packages", 9) : NULL;
+  int count = p ? 0 : -1, depth = 0;
+  for (p = p ? p + 9 : end; p < end && depth >= 0; p++) {
+    if (*p == '"') // skip strings, they can contain parentheses
+      for (p++; p < end && *p != '"'; p++)
+        if (*p == '\\') p++;
+    if (*p == '(' && ++depth == 2) count++;
+    if (*p == ')') depth--;
+  }
+  if (map) munmap((void*)map, len);
+  return count;
+}
+
+struct nix_refs {
+  const char* root_path; // store path whose closure is counted
+  int64_t root, max_id, (*refs)[2];
+  size_t ref_count, ref_size;
+};
+
+static void nix_find_path(void* arg, int64_t rowid, const unsigned char* record, size_t len) {
+  struct nix_refs* nix = arg;
+  struct sqlite_value path;
+  if (rowid > nix->max_id) nix->max_id = rowid;
+  if (sqlite_column(record, len, 1, &path) && path.text_len == strlen(nix->root_path) &&
+      memcmp(path.text, nix->root_path, path.text_len) == 0)
+    nix->root = rowid;
+}
+
+static void nix_add_ref(void* arg, int64_t rowid, const unsigned char* record, size_t len) {
+  (void)rowid;
+  struct nix_refs* nix = arg;
+  struct sqlite_value referrer, reference;
+  if (!sqlite_column(record, len, 0, &referrer) || !sqlite_column(record, len, 1, &reference)) return;
+  if (nix->ref_count == nix->ref_size) {
+    void* refs = realloc(nix->refs, (nix->ref_size = nix->ref_size ? nix->ref_size * 2 : 4096) * sizeof(*nix->refs));
+    if (!refs) return;
+    nix->refs = refs;
+  }
+  nix->refs[nix->ref_count][0]   = referrer.integer;
+  nix->refs[nix->ref_count++][1] = reference.integer;
+}
+
+static int compare_ref(const void* a, const void* b) {
+  int64_t x = ((const int64_t*)a)[0], y = ((const int64_t*)b)[0];
+  return (x > y) - (x < y);
+}
+
+// same as `nix-store -q --requisites root_path`: the closure of a store path, read from the nix database
+static int count_nix_closure(const char* path, const char* root_path) {
+  struct sqlite_db db;
+  if (sqlite_open(&db, path) != 0) return -1;
+  struct nix_refs nix = {root_path, 0, 0, NULL, 0, 0};
+  uint32_t paths_root = sqlite_table_root(&db, "ValidPaths"), refs_root = sqlite_table_root(&db, "Refs");
+  int count           = -1;
+  if (paths_root && refs_root && sqlite_walk(&db, paths_root, nix_find_path, &nix, 0) >= 0 && nix.root &&
+      sqlite_walk(&db, refs_root, nix_add_ref, &nix, 0) >= 0) {
+    qsort(nix.refs, nix.ref_count, sizeof(*nix.refs), compare_ref);
+    bool* visited  = calloc(nix.max_id + 1, sizeof(bool));
+    int64_t* stack = malloc((nix.max_id + 1) * sizeof(int64_t));
+    if (visited && stack) {
+      size_t top       = 0;
+      stack[top++]     = nix.root;
+      visited[nix.root] = true;
+      for (count = 1; top > 0;) { // depth first visit of the references graph
+        int64_t id = stack[--top];
+        size_t lo = 0, hi = nix.ref_count;
+        while (lo < hi) { // first reference of id
+          size_t mid = (lo + hi) / 2;
+          if (nix.refs[mid][0] < id)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+        for (; lo < nix.ref_count && nix.refs[lo][0] == id; lo++) {
+          int64_t ref = nix.refs[lo][1];
+          if (ref < 0 || ref > nix.max_id || visited[ref]) continue;
+          visited[ref] = true;
+          stack[top++] = ref;
+          count++;
+        }
+      }
+    }
+    free(visited);
+    free(stack);
+  }
+  free(nix.refs);
+  sqlite_close(&db);
+  return count;
+}
 
-  fclose(meminfo);
-  #endif
-#else // if __APPLE__
-  // Used
-  FILE *mem_wired_fp, *mem_active_fp, *mem_compressed_fp;
-  mem_wired_fp      = popen("vm_stat | awk '/wired/ { printf $4 }' | cut -d '.' -f 1", "r");
-  mem_active_fp     = popen("vm_stat | awk '/active/ { printf $3 }' | cut -d '.' -f 1", "r");
-  mem_compressed_fp = popen("vm_stat | awk '/occupied/ { printf $5 }' | cut -d '.' -f 1", "r");
-  char mem_wired_ch[2137], mem_active_ch[2137], mem_compressed_ch[2137];
-  while (fgets(mem_wired_ch, sizeof(mem_wired_ch), mem_wired_fp) != NULL)
-    while (fgets(mem_active_ch, sizeof(mem_active_ch), mem_active_fp) != NULL)
-      while (fgets(mem_compressed_ch, sizeof(mem_compressed_ch), mem_compressed_fp) != NULL)
-        ;
-
-  pclose(mem_wired_fp);
-  pclose(mem_active_fp);
-  pclose(mem_compressed_fp);
-
-  int mem_wired      = atoi(mem_wired_ch);
-  int mem_active     = atoi(mem_active_ch);
-  int mem_compressed = atoi(mem_compressed_ch);
+// the closure of the system profile
+static int count_nix(const char* path) {
+  char root_path[PATH_MAX];
+  return realpath("/run/current-system/sw", root_path) ? count_nix_closure(path, root_path) : -1;
+}
 
-  // Total
-  sysctlbyname("hw.memsize", &mem_buffer, &mem_buffer_len, NULL, 0);
-  user_info->ram_used  = ((mem_wired + mem_active + mem_compressed) * 4 / 1024);
-  user_info->ram_total = mem_buffer / 1024 / 1024;
-  LOG_V(user_info->ram_total);
-  LOG_V(user_info->ram_used);
-#endif
-  return 0;
+// homebrew lives in a different prefix on intel macs, apple silicon and linux
+static int count_brew(const char* path) {
+  const char* prefixes[] = {getenv("HOMEBREW_PREFIX"), "/opt/homebrew", "/usr/local", "/home/linuxbrew/.linuxbrew"};
+  for (int i = 0; i < 4; i++) {
+    if (!prefixes[i]) continue;
+    char brew_path[PATH_MAX];
+    snprintf(brew_path, sizeof(brew_path), "%s/%s", prefixes[i], path);
+    int count = count_dirs(AT_FDCWD, brew_path, 1);
+    if (count >= 0) return count;
+  }
+  return -1;
 }
+// identifies a version of a package database, the package count is read again only if it changes
+struct pkg_stamp {
+  long long ino, size, mtime, wal_size, wal_mtime; // sqlite databases commit to their -wal file first
+};
 
-// tries to get installed gpu(s)
-void* get_gpu(void* argp) {
-  if (!((struct thread_varg*)argp)->thread_flags[2]) return 0;
-  LOG_I("getting gpu(s)");
-  char* buffer           = ((struct thread_varg*)argp)->buffer;
-  struct info* user_info = ((struct thread_varg*)argp)->user_info;
-  int gpuc               = 0; // gpu counter
-#ifndef _WIN32
-  setenv("LANG", "en_US", 1); // force language to english
-#endif
-  FILE* gpu;
-#ifndef _WIN32
-  LOG_I("getting gpus with lshw");
-  gpu = popen("lshw -class display 2> /dev/null", "r");
+struct pkg_cache_entry {
+  char path[256]; // stamp_path of the package manager
+  struct pkg_stamp stamp;
+  int count;
+};
 
-  // add all gpus to the array gpu_model
-  while (fgets(buffer, BUFFER_SIZE, gpu))
-    if (sscanf(buffer, "    product: %[^\n]", user_info->gpu_model[gpuc])) gpuc++;
-#endif
+// package managers shared by the probing threads
+struct pkg_probe {
+  struct package_manager* pkgmans;
+  int pkgman_count, next;  // next package manager to probe
+  int* counts;             // package count of every package manager, -1 if it was not found
+  struct pkg_stamp* stamps;
+  bool *stamped, *recounted; // stamped package managers that were not found in the cache
+  struct pkg_cache_entry* cache;
+  int cache_count;
+  long long deadline; // commands are killed at this now_ms() time, 0 for no deadline
+  pthread_mutex_t lock;
+  bool killed; // a command of one of the probing threads was killed
+};
 
-  if (strlen(user_info->gpu_model[0]) < 2) {
-    // get gpus with lspci command
-    if (strcmp(user_info->os_name, "android") != 0) {
-#ifndef __APPLE__
-  #ifdef _WIN32
-      gpu = popen("wmic PATH Win32_VideoController GET Name", "r");
+static bool read_stamp(const char* stamp_path, struct pkg_stamp* stamp) {
+  char path[PATH_MAX];
+  struct stat st;
+  memset(stamp, 0, sizeof(*stamp));
+  if (!expand_home(stamp_path, path, sizeof(path)) || stat(path, &st) != 0) return false;
+  #ifdef __APPLE__
+    #define MTIME_NS(st) ((st).st_mtimespec.tv_sec * 1000000000LL + (st).st_mtimespec.tv_nsec)
   #else
-      gpu = popen("lspci -mm 2> /dev/null | grep \"VGA\" | awk -F '\"' '{print $4 $5 $6}'", "r");
+    #define MTIME_NS(st) ((st).st_mtim.tv_sec * 1000000000LL + (st).st_mtim.tv_nsec)
   #endif
-#else
-      gpu = popen(
-          "system_profiler SPDisplaysDataType | awk -F ': ' '/Chipset Model: /{ print $2 }'", "r");
-#endif
-    } else
-      gpu = popen("getprop ro.hardware.vulkan 2> /dev/null", "r"); // for android
+  stamp->ino   = st.st_ino;
+  stamp->size  = st.st_size;
+  stamp->mtime = MTIME_NS(st);
+  strncat(path, "-wal", sizeof(path) - strlen(path) - 1);
+  if (stat(path, &st) == 0) {
+    stamp->wal_size  = st.st_size;
+    stamp->wal_mtime = MTIME_NS(st);
   }
+  #undef MTIME_NS
+  return true;
+}
 
-  // get all the gpus
-  while (fgets(buffer, BUFFER_SIZE, gpu)) {
-    // windows
-    if (strstr(buffer, "Name") || (strlen(buffer) == 2))
-      continue;
-    else if (sscanf(buffer, "%[^\n]", user_info->gpu_model[gpuc]))
-      gpuc++;
+static int read_pkg_cache(struct pkg_cache_entry* entries, int max) {
+  char cache_file[PATH_MAX], buffer[512];
+  if (!get_cache_path(PKG_CACHE_FILE, cache_file, sizeof(cache_file))) return 0;
+  FILE* cache_fp = fopen(cache_file, "r");
+  if (!cache_fp) return 0;
+  int count = 0;
+  while (count < max && fgets(buffer, sizeof(buffer), cache_fp)) {
+    struct pkg_cache_entry* entry = &entries[count];
+    if (sscanf(buffer, "%lld %lld %lld %lld %lld %d %255[^\n]", &entry->stamp.ino, &entry->stamp.size, &entry->stamp.mtime,
+               &entry->stamp.wal_size, &entry->stamp.wal_mtime, &entry->count, entry->path) == 7)
+      count++;
   }
-  fclose(gpu);
+  fclose(cache_fp);
+  return count;
+}
 
-  // format gpu names
-  for (int i = 0; i < gpuc; i++) {
-    remove_brackets(user_info->gpu_model[i]);
-    truncate_str(user_info->gpu_model[i], user_info->target_width);
-    LOG_V(user_info->gpu_model[i]);
+// rewrites the package count cache, through a temporary file so that concurrent runs never read half of it
+static void write_pkg_cache(struct pkg_probe* probe) {
+  char cache_file[PATH_MAX], tmp_file[PATH_MAX + 16];
+  if (!get_cache_path(PKG_CACHE_FILE, cache_file, sizeof(cache_file))) return;
+  FILE* cache_fp = create_temp(cache_file, tmp_file, sizeof(tmp_file));
+  if (!cache_fp) {
+    LOG_E("Failed to write to %.1024s!", cache_file); // bounded, the log line is shorter than a path can be
+    return;
   }
-  return 0;
+  for (int i = 0; i < probe->pkgman_count; i++) {
+    struct pkg_stamp* stamp = &probe->stamps[i];
+    if (probe->stamped[i] && probe->counts[i] >= 0)
+      fprintf(cache_fp, "%lld %lld %lld %lld %lld %d %s\n", stamp->ino, stamp->size, stamp->mtime, stamp->wal_size,
+              stamp->wal_mtime, probe->counts[i], probe->pkgmans[i].stamp_path);
+  }
+  // package managers out of the scope of this run (see enum pkg_scope) keep their entries
+  for (int j = 0; j < probe->cache_count; j++) {
+    struct pkg_cache_entry* entry = &probe->cache[j];
+    bool probed                   = false;
+    for (int i = 0; i < probe->pkgman_count && !probed; i++)
+      probed = probe->pkgmans[i].stamp_path && strcmp(probe->pkgmans[i].stamp_path, entry->path) == 0;
+    if (!probed)
+      fprintf(cache_fp, "%lld %lld %lld %lld %lld %d %s\n", entry->stamp.ino, entry->stamp.size, entry->stamp.mtime, entry->stamp.wal_size,
+              entry->stamp.wal_mtime, entry->count, entry->path);
+  }
+  if (fclose(cache_fp) != 0 || rename(tmp_file, cache_file) != 0) remove(tmp_file);
 }
 
-// tries to get screen resolution
-#ifndef _WIN32
-void* get_res(void* argp) {
-  if (!((struct thread_varg*)argp)->thread_flags[3]) return 0;
-  LOG_I("getting resolution");
-  char* buffer           = ((struct thread_varg*)argp)->buffer;
-  struct info* user_info = ((struct thread_varg*)argp)->user_info;
-  FILE* resolution       = popen("xwininfo -root 2> /dev/null | grep -E 'Width|Height'", "r");
-  while (fgets(buffer, BUFFER_SIZE, resolution)) {
-    sscanf(buffer, "  Width: %d", &user_info->screen_width);
-    sscanf(buffer, "  Height: %d", &user_info->screen_height);
+// counts the packages of a single package manager, from the cache, its database or running its command
+static int probe_pkgman(struct pkg_probe* probe, int i) {
+  struct package_manager* current = &probe->pkgmans[i];
+  LOG_I("trying pkgman %s", current->pkgman_name);
+  if (current->stamp_path && (probe->stamped[i] = read_stamp(current->stamp_path, &probe->stamps[i]))) {
+    for (int j = 0; j < probe->cache_count; j++)
+      if (strcmp(probe->cache[j].path, current->stamp_path) == 0 &&
+          memcmp(&probe->cache[j].stamp, &probe->stamps[i], sizeof(struct pkg_stamp)) == 0) {
+        LOG_I("pkgman %s did not change since the last run", current->pkgman_name);
+        return probe->cache[j].count;
+      }
+    probe->recounted[i] = true;
   }
-  LOG_V(user_info->screen_width);
-  LOG_V(user_info->screen_height);
-#else
-void* get_res() {
-  // TODO: get resolution on windows
-#endif
-  return 0;
+  int pkg_count = current->count_native ? current->count_native(current->db_path) : -1;
+  LOG_V(pkg_count);
+  if (pkg_count < 0) {
+    LOG_V(current->command_path);
+    if (access(current->command_path, F_OK) != -1) {
+      char output[64];
+      if (run_command(current->command_string, output, sizeof(output), command_timeout(probe->deadline, PKG_PROBE_TIMEOUT)) < 0 ||
+          sscanf(output, "%d", &pkg_count) != 1)
+        pkg_count = -1;
+    } else {
+      LOG_W("pkgman %s executable not found!", current->pkgman_name);
+    }
+  }
+  return pkg_count;
 }
 
+static void* probe_pkgmans(void* argp) {
+  struct pkg_probe* probe = argp;
+  for (;;) {
+    pthread_mutex_lock(&probe->lock);
+    int i = probe->next++;
+    probe->killed |= command_killed;
+    pthread_mutex_unlock(&probe->lock);
+    if (i >= probe->pkgman_count) return 0;
+    bool waiting     = swap_pending(false); // in fetch_start the commands of all the package managers start at once
+    probe->counts[i] = probe_pkgman(probe, i);
+    swap_pending(swap_pending(false) || waiting);
+  }
+}
+#endif // _WIN32
+
 // tries to get the installed package count and package managers name
 void* get_pkg(void* argp) { // this is just a function that returns the total of installed packages
   if (!((struct thread_varg*)argp)->thread_flags[4]) return 0;
   LOG_I("getting pkgs");
   struct info* user_info = ((struct thread_varg*)argp)->user_info;
-  user_info->pkgs        = 0;
+  if (user_info->pkg_scope != PKGS_USER) { // the packages of the user are added to the others
+    user_info->pkgs           = 0;
+    user_info->pkgman_name[0] = '\0';
+  }
 #ifndef __APPLE__
   #ifndef _WIN32
   // all supported package managers
   struct package_manager pkgmans[] = {
-      {PKGPATH "apt", "apt list --installed 2> /dev/null | wc -l", "(apt)"},
-      {PKGPATH "apk", "apk info 2> /dev/null | wc -l", "(apk)"},
+      {PKGPATH "apt", "apt list --installed 2> /dev/null | wc -l", "(apt)", count_dpkg, "/var/lib/dpkg/status", "/var/lib/dpkg/status", false},
+      {PKGPATH "apk", "apk info 2> /dev/null | wc -l", "(apk)", count_apk, "/lib/apk/db/installed", "/lib/apk/db/installed", false},
       // {PKGPATH"dnf","dnf list installed 2> /dev/null | wc -l", "(dnf)"}, // according to https://stackoverflow.com/questions/48570019/advantages-of-dnf-vs-rpm-on-fedora, dnf and rpm return the same number of packages
-      {PKGPATH "qlist", "qlist -I 2> /dev/null | wc -l", "(emerge)"},
-      {PKGPATH "flatpak", "flatpak list 2> /dev/null | wc -l", "(flatpak)"},
-      {PKGPATH "snap", "snap list 2> /dev/null | wc -l", "(snap)"},
-      {PKGPATH "guix", "guix package --list-installed 2> /dev/null | wc -l", "(guix)"},
-      {PKGPATH "nix-store", "nix-store -q --requisites /run/current-system/sw 2> /dev/null | wc -l", "(nix)"},
-      {PKGPATH "pacman", "pacman -Qq 2> /dev/null | wc -l", "(pacman)"},
-      {PKGPATH "pkg", "pkg info 2>/dev/null | wc -l", "(pkg)"},
-      {PKGPATH "pkg_info", "pkg_info 2>/dev/null | wc -l | sed \"s/ //g\"", "(pkg)"},
-      {PKGPATH "port", "port installed 2> /dev/null | tail -n +2 | wc -l", "(port)"},
-      {PKGPATH "brew", "find $(brew --cellar 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}'", "(brew-cellar)"},
-      {PKGPATH "brew", "find $(brew --caskroom 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}'", "(brew-cask)"},
-      {PKGPATH "rpm", "rpm -qa --last 2> /dev/null | wc -l", "(rpm)"},
-      {PKGPATH "xbps-query", "xbps-query -l 2> /dev/null | wc -l", "(xbps)"}};
+    #ifndef __OPENBSD__
+      {PKGPATH "qlist", "qlist -I 2> /dev/null | wc -l", "(emerge)", count_portage, "/var/db/pkg", NULL, false},
+    #else
+      {PKGPATH "qlist", "qlist -I 2> /dev/null | wc -l", "(emerge)", NULL, NULL, NULL, false},
+    #endif
+      {PKGPATH "flatpak", "flatpak list --system 2> /dev/null | wc -l", "(flatpak)", count_flatpak, "/var/lib/flatpak", NULL, false},
+      {PKGPATH "flatpak", "flatpak list --user 2> /dev/null | wc -l", "(flatpak)", count_flatpak, "~/.local/share/flatpak", NULL, true},
+      {PKGPATH "snap", "snap list 2> /dev/null | wc -l", "(snap)", count_snap, "/var/lib/snapd/snaps", "/var/lib/snapd/snaps", false},
+      {PKGPATH "guix", "guix package --list-installed 2> /dev/null | wc -l", "(guix)", count_guix, "~/.guix-profile/manifest", "~/.guix-profile/manifest", true},
+      {PKGPATH "nix-store", "nix-store -q --requisites /run/current-system/sw 2> /dev/null | wc -l", "(nix)", count_nix, "/nix/var/nix/db/db.sqlite", "/run/current-system", false},
+      {PKGPATH "pacman", "pacman -Qq 2> /dev/null | wc -l", "(pacman)", count_pacman, "/var/lib/pacman/local", "/var/lib/pacman/local", false},
+      {PKGPATH "pkg", "pkg info 2>/dev/null | wc -l", "(pkg)", count_pkgng, "/var/db/pkg/local.sqlite", "/var/db/pkg/local.sqlite", false},
+    #ifdef __OPENBSD__
+      {PKGPATH "pkg_info", "pkg_info 2>/dev/null | wc -l | sed \"s/ //g\"", "(pkg)", count_pkg_info, "/var/db/pkg", "/var/db/pkg", false},
+    #else
+      {PKGPATH "pkg_info", "pkg_info 2>/dev/null | wc -l | sed \"s/ //g\"", "(pkg)", NULL, NULL, NULL, false},
+    #endif
+      {PKGPATH "port", "port installed 2> /dev/null | tail -n +2 | wc -l", "(port)", count_macports, "/opt/local/var/macports/registry/registry.db", "/opt/local/var/macports/registry/registry.db", false},
+      {PKGPATH "brew", "find $(brew --cellar 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}'", "(brew-cellar)", count_brew, "Cellar", NULL, true},
+      {PKGPATH "brew", "find $(brew --caskroom 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}'", "(brew-cask)", count_brew, "Caskroom", NULL, true},
+      {PKGPATH "rpm", "rpm -qa --last 2> /dev/null | wc -l", "(rpm)", count_rpm, "/var/lib/rpm/rpmdb.sqlite", "/var/lib/rpm/rpmdb.sqlite", false},
+      {PKGPATH "xbps-query", "xbps-query -l 2> /dev/null | wc -l", "(xbps)", count_xbps, "/var/db/xbps/pkgdb-0.38.plist", "/var/db/xbps/pkgdb-0.38.plist", false}};
   #endif
 #else
-  struct package_manager pkgmans[] = {{"/usr/local/bin/brew", "find $(brew --cellar 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}' > /tmp/uwufetch_brew_tmp", "(brew-cellar)"},
-                                      {"/usr/local/bin/brew", "find $(brew --caskroom 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}' > /tmp/uwufetch_brew_tmp", "(brew-cask)"}};
+  struct package_manager pkgmans[] = {{"/opt/local/bin/port", "port installed 2> /dev/null | tail -n +2 | wc -l", "(port)", count_macports, "/opt/local/var/macports/registry/registry.db", "/opt/local/var/macports/registry/registry.db", false},
+                                      {"/usr/local/bin/brew", "find $(brew --cellar 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}'", "(brew-cellar)", count_brew, "Cellar", NULL, true},
+                                      {"/usr/local/bin/brew", "find $(brew --caskroom 2>/dev/stdout) -maxdepth 1 -type d 2> /dev/null | wc -l | awk '{print $1}'", "(brew-cask)", count_brew, "Caskroom", NULL, true}};
 #endif
 #ifndef _WIN32
-  const int pkgman_count = sizeof(pkgmans) / sizeof(pkgmans[0]); // number of package managers
-  int comma_separator    = 0;
-  for (int i = 0; i < pkgman_count; i++) {
-    struct package_manager* current = &pkgmans[i]; // pointer to current package manager
-
-    unsigned int pkg_count = 0;
-    LOG_I("trying pkgman %d: %s", i, current->pkgman_name);
-    LOG_V(current->command_path);
-    if (access(current->command_path, F_OK) != -1) {
-  #ifndef __APPLE__
-      FILE* fp = popen(current->command_string, "r"); // trying current package manager
-  #else
-      system(current->command_string); // writes to a temporary file: for some reason popen() does not intercept the stdout, so i have to read from a temporary file
-      FILE* fp = fopen("/tmp/uwufetch_brew_tmp", "r");
-  #endif
-      if (fscanf(fp, "%u", &pkg_count) == 3) continue;
-
-  #ifndef __APPLE__
-      pclose(fp);
-  #else
-      // remove("/tmp/uwufetch_brew_tmp");
-      fclose(fp);
-  #endif
+  int pkgman_count = 0; // number of package managers in the scope
+  for (size_t i = 0; i < sizeof(pkgmans) / sizeof(pkgmans[0]); i++)
+    if (user_info->pkg_scope == PKGS_ALL || pkgmans[i].per_user == (user_info->pkg_scope == PKGS_USER)) pkgmans[pkgman_count++] = pkgmans[i];
+  int counts[pkgman_count];
+  struct pkg_stamp stamps[pkgman_count];
+  bool stamped[pkgman_count], recounted[pkgman_count];
+  struct pkg_cache_entry cache[PKG_CACHE_ENTRIES];
+  memset(stamped, 0, sizeof(stamped));
+  memset(recounted, 0, sizeof(recounted));
+  struct pkg_probe probe = {pkgmans, pkgman_count, 0, counts, stamps, stamped, recounted,
+                            cache, read_pkg_cache(cache, PKG_CACHE_ENTRIES), ((struct thread_varg*)argp)->deadline, PTHREAD_MUTEX_INITIALIZER, false};
+  pthread_t workers[PKG_PROBE_THREADS];
+  int worker_count = 0;
+  while (worker_count < PKG_PROBE_THREADS && worker_count < pkgman_count && !collecting_async() &&
+         pthread_create(&workers[worker_count], NULL, probe_pkgmans, &probe) == 0)
+    worker_count++;
+  if (worker_count == 0) probe_pkgmans(&probe); // could not start any thread or started by fetch_start, probing them here
+  for (int i = 0; i < worker_count; i++) pthread_join(workers[i], NULL);
+  command_killed |= probe.killed; // the scheduler only sees the flag of this thread
+  for (int i = 0; i < pkgman_count; i++)
+    if (recounted[i]) {
+      write_pkg_cache(&probe);
+      break;
     }
-  #ifdef __DEBUG__
-    else
-      LOG_W("pkgman %s executable not found!", current->pkgman_name);
-  #endif
 
-    // adding a package manager with its package count to user_info->pkgman_name
-    user_info->pkgs += pkg_count;
-    if (pkg_count > 0) {
-      if (comma_separator++) strcat(user_info->pkgman_name, ", ");
-      char spkg_count[16];
-      sprintf(spkg_count, "%u", pkg_count);
-      strcat(user_info->pkgman_name, spkg_count);
-      strcat(user_info->pkgman_name, " ");
-      strcat(user_info->pkgman_name, current->pkgman_name);
-      LOG_V(user_info->pkgman_name);
-    }
+  // installations of the same package manager are shown together
+  for (int i = 0; i < pkgman_count; i++)
+    for (int j = 0; j < i; j++)
+      if (counts[i] > 0 && counts[j] >= 0 && strcmp(pkgmans[i].pkgman_name, pkgmans[j].pkgman_name) == 0) {
+        counts[j] += counts[i];
+        counts[i] = 0;
+      }
+
+  // adding the package managers with their package count to user_info->pkgman_name, always in the same order
+  char* pkgman_name                        = user_info->pkgman_name + strlen(user_info->pkgman_name);
+  char* pkgman_name_end                    = user_info->pkgman_name + sizeof(user_info->pkgman_name);
+  ((struct thread_varg*)argp)->unavailable = true; // until a package manager is found, even with no packages
+  for (int i = 0; i < pkgman_count; i++) {
+    if (counts[i] >= 0) ((struct thread_varg*)argp)->unavailable = false;
+    if (counts[i] <= 0) continue;
+    user_info->pkgs += counts[i];
+    // the list is cut when it does not fit, but every package is still counted
+    int written = snprintf(pkgman_name, pkgman_name_end - pkgman_name, "%s%d %s", pkgman_name > user_info->pkgman_name ? ", " : "",
+                           counts[i], pkgmans[i].pkgman_name);
+    if (written > 0) pkgman_name += written < pkgman_name_end - pkgman_name ? written : pkgman_name_end - pkgman_name - 1;
+    LOG_V(user_info->pkgman_name);
   }
 #else  // _WIN32
   // chocolatey for windows
@@ -440,25 +2245,46 @@ void* get_pkg(void* argp) { // this is just a function that returns the total of
   if (fp) pclose(fp);
 
   user_info->pkgs = pkg_count;
-  char spkg_count[16];
-  sprintf(spkg_count, "%u", pkg_count);
-  strcat(user_info->pkgman_name, spkg_count);
-  strcat(user_info->pkgman_name, " ");
-  strcat(user_info->pkgman_name, "(chocolatey)");
+  snprintf(user_info->pkgman_name, sizeof(user_info->pkgman_name), "%u (chocolatey)", pkg_count);
   LOG_V(user_info->pkgman_name);
 #endif // _WIN32
   return 0;
 }
 
+#ifdef __linux__
+static const char* const dmi_model_paths[] = {"/sys/devices/virtual/dmi/id/product_version", "/sys/devices/virtual/dmi/id/product_name",
+                                               "/sys/devices/virtual/dmi/id/board_name"};
+
+// looks for key=value at the start of a line in an android build.prop
+static bool read_build_prop(const char* path, const char* key, char* value, size_t len) {
+  const unsigned char* map;
+  size_t map_len;
+  if (map_file(path, &map, &map_len) != 0 || !map) return false;
+  bool found                = false;
+  size_t key_len            = strlen(key);
+  const unsigned char *line = map, *end = map + map_len;
+  while (line < end && !found) {
+    const unsigned char* eol = memchr(line, '\n', end - line);
+    if (!eol) eol = end;
+    if ((size_t)(eol - line) > key_len && memcmp(line, key, key_len) == 0 && line[key_len] == '=') {
+      snprintf(value, len, "%.*s", (int)(eol - line - key_len - 1), line + key_len + 1);
+      found = true;
+    }
+    line = eol + 1;
+  }
+  munmap((void*)map, map_len);
+  return found;
+}
+#endif // __linux__
+
 void* get_model(void* argp) {
   if (!((struct thread_varg*)argp)->thread_flags[5]) return 0;
   LOG_I("getting model");
   struct info* user_info = ((struct thread_varg*)argp)->user_info;
   char* buffer           = ((struct thread_varg*)argp)->buffer;
-  FILE* model_fp;
 #ifdef _WIN32
   // all the previous files obviously did not exist on windows
-  model_fp = popen("wmic computersystem get model", "r");
+  FILE* model_fp = popen("wmic computersystem get model", "r");
   while (fgets(buffer, BUFFER_SIZE, model_fp)) {
     if (strstr(buffer, "Model") != 0)
       continue;
@@ -476,8 +2302,9 @@ void* get_model(void* argp) {
   #elif defined(__OPENBSD__)
     #define HOSTCTL "hw.product"
   #endif
-  model_fp = popen("sysctl " HOSTCTL, "r");
-  while (fgets(buffer, BUFFER_SIZE, model_fp))
+  char command_output[BUFFER_SIZE * 4];
+  FILE* model_fp = open_command("sysctl " HOSTCTL, ((struct thread_varg*)argp)->deadline, command_output, sizeof(command_output));
+  while (model_fp && fgets(buffer, BUFFER_SIZE, model_fp))
     if (sscanf(buffer,
                HOSTCTL
   #ifdef __OPENBSD__
@@ -488,46 +2315,37 @@ void* get_model(void* argp) {
                "%[^\n]",
                user_info->model))
       break;
-  pclose(model_fp);
-#else
-  char model_filename[4][256] = {
-      "/sys/devices/virtual/dmi/id/product_version",
-      "/sys/devices/virtual/dmi/id/product_name",
-      "/sys/devices/virtual/dmi/id/board_name",
-      "getprop ro.product.vendor.marketname 2>/dev/null",
-  };
-
-  char tmp_model[4][BUFFER_SIZE] = {0}; // temporary variable to store the contents of all 3 files
-  int longest_model = 0, best_len = 0, currentlen = 0;
-  FILE* (*tocall[])(const char*, const char*) = {fopen, fopen, fopen, popen}; // open a process or a file, depending on the model_filename
-  int (*tocall_close[])(FILE*)                = {fclose, fclose, fclose, pclose};
-  for (int i = 0; i < 4; i++) {
-    // read file
-    model_fp = tocall[i](model_filename[i], "r");
-    if (model_fp) {
-      fgets(tmp_model[i], BUFFER_SIZE, model_fp);
-      tmp_model[i][strlen(tmp_model[i]) - 1] = '\0';
-      tocall_close[i](model_fp);
-    }
-    LOG_V(tmp_model[i]);
-    // choose the file with the longest name
-    currentlen = strlen(tmp_model[i]);
-    if (currentlen > best_len) {
-      best_len      = currentlen;
-      longest_model = i;
-    }
-  }
-  if (strlen(tmp_model[longest_model]) == 0) {
-    model_fp = popen("lscpu 2>/dev/null", "r");
-    while (fgets(buffer, BUFFER_SIZE, model_fp))
-      if (sscanf(buffer, "Model name:%*[           |		]%[^\n]", tmp_model[longest_model]) == 1) break;
-    pclose(model_fp);
-    LOG_V(tmp_model[longest_model]);
-    if (strcmp(tmp_model[longest_model], "Icestorm") == 0) sprintf(tmp_model[longest_model], "Apple MacBook Air (M1)");
-  }
-  sprintf(user_info->model, "%s", tmp_model[longest_model]);
+  if (model_fp) close_command(model_fp);
+#elif defined(__linux__)
+  // every source is read, the longest name wins like before
+  struct file_batch* files = ((struct thread_varg*)argp)->files;
+  char tmp_model[BUFFER_SIZE];
+  user_info->model[0] = '\0';
+  for (size_t i = 0; i < sizeof(dmi_model_paths) / sizeof(dmi_model_paths[0]); i++)
+    if (read_batched(files, dmi_model_paths[i], tmp_model, sizeof(tmp_model)) > (int)strlen(user_info->model))
+      strcpy(user_info->model, tmp_model);
+  // arm boards, android devices
+  if (read_batched(files, "/proc/device-tree/model", tmp_model, sizeof(tmp_model)) > 0 && strlen(tmp_model) > strlen(user_info->model))
+    strcpy(user_info->model, tmp_model);
+  if ((read_build_prop("/vendor/build.prop", "ro.product.vendor.marketname", tmp_model, sizeof(tmp_model)) ||
+       read_build_prop("/system/build.prop", "ro.product.vendor.marketname", tmp_model, sizeof(tmp_model))) &&
+      strlen(tmp_model) > strlen(user_info->model))
+    strcpy(user_info->model, tmp_model);
+  // the property can also come from places getprop knows better, like the odm partition
+  if (!user_info->model[0] && access("/system/bin/getprop", X_OK) == 0 &&
+      run_command("getprop ro.product.vendor.marketname", buffer, BUFFER_SIZE, command_timeout(((struct thread_varg*)argp)->deadline, GETPROP_TIMEOUT)) > 0 && sscanf(buffer, "%255[^\n]", tmp_model) == 1)
+    strcpy(user_info->model, tmp_model);
+  if (!user_info->model[0]) { // at least name the cpu cores, like lscpu did
+    const char* part = arm_part_name(0);
+    char cpuinfo[2048], *model_name;
+    if (part)
+      sprintf(user_info->model, "%s", strcmp(part, "Icestorm") == 0 ? "Apple MacBook Air (M1)" : part);
+    else if (read_small_file(AT_FDCWD, "/proc/cpuinfo", cpuinfo, sizeof(cpuinfo)) > 0 && (model_name = strstr(cpuinfo, "model name")))
+      sscanf(model_name, "model name%*[ \t]: %255[^\n]", user_info->model);
+  }
   LOG_V(user_info->model);
 #endif
+  ((struct thread_varg*)argp)->unavailable = !user_info->model[0];
   return 0;
 }
 
@@ -556,6 +2374,7 @@ void* get_ker(void* argp) {
   }
   if (kernel_fp) pclose(kernel_fp);
 #endif // _WIN32
+  ((struct thread_varg*)argp)->unavailable = !user_info->kernel[0];
   return 0;
 }
 
@@ -565,10 +2384,12 @@ void* get_upt(void* argp) {
   LOG_I("getting uptime");
   struct info* user_info = ((struct thread_varg*)argp)->user_info;
 #ifdef __APPLE__
-  int mib[2] = {CTL_KERN, KERN_BOOTTIME};
-  sysctl(mib, 2, &time_buffer, &time_buffer_len, NULL, 0);
+  int mib[2]               = {CTL_KERN, KERN_BOOTTIME};
+  struct timeval boot_time = {0};
+  size_t boot_time_len     = sizeof(boot_time);
+  if (sysctl(mib, 2, &boot_time, &boot_time_len, NULL, 0) != 0) ((struct thread_varg*)argp)->unavailable = true;
 
-  time_t bsec = time_buffer.tv_sec;
+  time_t bsec = boot_time.tv_sec;
   time_t csec = time(NULL);
 
   user_info->uptime = difftime(csec, bsec);
@@ -576,11 +2397,14 @@ void* get_upt(void* argp) {
   #ifdef __BSD__
   // https://github.com/coreutils/coreutils/blob/master/src/uptime.c
   int boot_time         = 0;
-  static int request[2] = {CTL_KERN, KERN_BOOTTIME};
+  int request[2]        = {CTL_KERN, KERN_BOOTTIME};
   struct timeval result;
   size_t result_len = sizeof result;
 
-  if (sysctl(request, 2, &result, &result_len, NULL, 0) >= 0) boot_time = result.tv_sec;
+  if (sysctl(request, 2, &result, &result_len, NULL, 0) >= 0)
+    boot_time = result.tv_sec;
+  else
+    ((struct thread_varg*)argp)->unavailable = true;
   int time_now      = time(NULL);
   user_info->uptime = time_now - boot_time;
   #else
@@ -595,34 +2419,199 @@ void* get_upt(void* argp) {
   return 0;
 }
 
-// Retrieves system information
-void get_info(struct flags flags, struct info* user_info) {
-  char buffer[BUFFER_SIZE]; // line buffer
-  get_twidth(user_info);
-  // os version, cpu and board info
-#ifdef __OPENBSD__
-  FILE* os_release = popen("echo ID=openbsd", "r"); // os-release does not exist in OpenBSD
+#define COLLECTOR_THREADS 4                // at most this many collectors run at the same time
+#define COLLECTOR_STACK_SIZE (128 * 1024) // collectors keep their buffers on the stack, none needs more than ~40KiB
+
+// a collector and what it needs to run
+struct collector_task {
+  void* (*run)(void*);
+  void* arg;
+  unsigned deps;     // bitmask of the tasks that have to be done before this one starts
+  unsigned fields;   // FETCH_* fields filled by the task
+  bool* unavailable; // set by the collector when it found nothing
+  struct thread_varg args;
+  char scratch[BUFFER_SIZE]; // line buffer of the collector
+};
+
+// args of get_os, which is not one of the thread_varg collectors
+struct os_varg {
+  struct info* user_info;
+  struct file_batch* files;
+  struct flags flags;
+  bool unavailable;
+};
+
+// a get_info run, shared with its collector threads: with a deadline get_info can return while collectors are still
+// blocked (a hung nfs mount or x server), so it is allocated and freed by the last thread that leaves it
+struct collection {
+  struct info work;       // written by the collectors
+  struct info* user_info; // gets the fields of every task when it is done, NULL once get_info stopped waiting
+  struct file_batch files;
+  struct os_varg os_args;
+  struct collector_task tasks[10];
+  int count;
+  unsigned started, done;                                              // bitmasks of tasks
+  long long deadline;                                                  // now_ms() time at which get_info returns, 0 for none
+  void (*finished)(unsigned fields, enum fetch_error error, void* arg); // called when a task is done, can be NULL
+  void* finished_arg;
+  int references; // threads using the collection
+#ifndef _WIN32
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+};
+
+// outcome of a task that just ran on this thread, a task cut short by the deadline timed out
+static enum fetch_error task_error(const struct collection* collection, const struct collector_task* task) {
+#ifndef _WIN32
+  if (collection->deadline && now_ms() >= collection->deadline && (command_killed || *task->unavailable)) return FETCH_TIMEOUT;
+#else
+  (void)collection;
+#endif
+  return *task->unavailable ? FETCH_UNAVAILABLE : FETCH_OK;
+}
+
+// runs the tasks whose dependencies are done until there are none left, or get_info stopped waiting for them
+static void run_scheduled(struct collection* collection) {
+#ifndef _WIN32
+  pthread_mutex_lock(&collection->lock);
+#endif
+  while (collection->user_info) {
+    int next = -1, pending = 0;
+    for (int i = 0; i < collection->count && next < 0; i++) {
+      if (collection->started & 1U << i) continue;
+      if ((collection->tasks[i].deps & collection->done) == collection->tasks[i].deps)
+        next = i;
+      else
+        pending++;
+    }
+    if (next < 0) {
+      if (!pending) break;
+#ifndef _WIN32
+      pthread_cond_wait(&collection->cond, &collection->lock); // another worker is running a dependency
+#endif
+      continue;
+    }
+    collection->started |= 1U << next;
+#ifndef _WIN32
+    pthread_mutex_unlock(&collection->lock);
+#endif
+    struct collector_task* task = &collection->tasks[next];
+#ifndef _WIN32
+    command_killed = false;
+#endif
+    task->run(task->arg);
+    enum fetch_error error = task_error(collection, task);
+#ifndef _WIN32
+    pthread_mutex_lock(&collection->lock);
+    pthread_cond_broadcast(&collection->cond);
+#endif
+    if (collection->user_info) { // the info of the caller is only written under the lock, while it is still waiting
+      info_copy_fields(collection->user_info, &collection->work, task->fields);
+      if (collection->finished) collection->finished(task->fields, error, collection->finished_arg);
+    }
+    collection->done |= 1U << next;
+  }
+#ifndef _WIN32
+  pthread_mutex_unlock(&collection->lock);
+#endif
+}
+
+// drops a reference to the collection, the last one frees it
+static void release_collection(struct collection* collection) {
+#ifndef _WIN32
+  pthread_mutex_lock(&collection->lock);
+  bool last = --collection->references == 0;
+  pthread_mutex_unlock(&collection->lock);
+  if (!last) return;
+  pthread_cond_destroy(&collection->cond);
+  pthread_mutex_destroy(&collection->lock);
+#endif
+  free(collection);
+}
+
+#ifndef _WIN32
+static void* run_collector_thread(void* arg) {
+  run_scheduled(arg);
+  release_collection(arg);
+  return NULL;
+}
+#endif
+
+// runs the tasks on up to COLLECTOR_THREADS threads, the calling one included when it can wait for all of them,
+// the tasks not done at the deadline time out
+static void run_tasks(struct collection* collection) {
+#ifndef _WIN32
+  pthread_mutex_init(&collection->lock, NULL);
+  pthread_cond_init(&collection->cond, NULL);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, COLLECTOR_STACK_SIZE);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  int worker_count = 0, max_workers = collection->deadline ? COLLECTOR_THREADS : COLLECTOR_THREADS - 1;
+  collection->references = 1;
+  while (worker_count < max_workers && worker_count < collection->count - !collection->deadline) {
+    collection->references++; // before the thread can release it
+    if (pthread_create(&(pthread_t){0}, &attr, run_collector_thread, collection) != 0) {
+      collection->references--;
+      break;
+    }
+    worker_count++;
+  }
+  pthread_attr_destroy(&attr);
+  LOG_I("running %d collectors on %d threads", collection->count, worker_count + !collection->deadline);
+  if (!collection->deadline || !worker_count) run_scheduled(collection); // tasks are in dependency order, so this runs them all when there are no threads
+
+  unsigned all = (1U << collection->count) - 1;
+  pthread_mutex_lock(&collection->lock);
+  while (collection->done != all) {
+    long long left = collection->deadline - now_ms();
+    if (collection->deadline && left <= 0) break;
+    if (!collection->deadline) {
+      pthread_cond_wait(&collection->cond, &collection->lock);
+      continue;
+    }
+    struct timespec until; // the monotonic clock can not be used with pthread_cond_timedwait on every system
+    clock_gettime(CLOCK_REALTIME, &until);
+    long long nanoseconds = until.tv_nsec + left % 1000 * 1000000;
+    until.tv_sec += left / 1000 + nanoseconds / 1000000000;
+    until.tv_nsec = nanoseconds % 1000000000;
+    pthread_cond_timedwait(&collection->cond, &collection->lock, &until);
+  }
+  for (int i = 0; i < collection->count; i++) {
+    if (collection->done & 1U << i) continue;
+    LOG_W("stopped waiting at the deadline for the collector of the fields %#x", collection->tasks[i].fields);
+    collection->user_info->timed_out |= collection->tasks[i].fields;
+    if (collection->finished) collection->finished(collection->tasks[i].fields, FETCH_TIMEOUT, collection->finished_arg);
+  }
+  collection->user_info = NULL; // the collectors still running only write their own copy from now on
+  pthread_mutex_unlock(&collection->lock);
 #else
-  FILE* os_release  = fopen("/etc/os-release", "r"); // os name file
+  run_scheduled(collection);
 #endif
-#ifndef __BSD__
-  FILE* cpuinfo = fopen("/proc/cpuinfo", "r"); // cpu name file for not-freebsd systems
+  release_collection(collection);
+}
+
+// tries to get the os name, or android/macos/ios/windows when there is no os-release
+static void* get_os(void* argp) {
+  struct info* user_info   = ((struct os_varg*)argp)->user_info;
+  struct file_batch* files = ((struct os_varg*)argp)->files;
+  struct flags flags       = ((struct os_varg*)argp)->flags;
+
+  char os_id[64] = "";
+#ifdef __OPENBSD__
+  bool os_release = true; // os-release does not exist in OpenBSD
+  sprintf(os_id, "openbsd");
 #else
-  FILE* cpuinfo     = popen("sysctl hw.model", "r"); // cpu name command for freebsd
+  static const char* const os_release_keys[] = {"ID"};
+  char os_release_buffer[4096]; // os name file
+  bool os_release = scan_batched(files, "/etc/os-release", os_release_buffer, sizeof(os_release_buffer), '=', os_release_keys, 1, store_unquoted, os_id) >= 0;
 #endif
   // trying to get some kind of information about the name of the computer (hopefully a product full name)
   if (os_release) { // get normal vars if os_release exists
     if (flags.os) {
       LOG_I("getting os name from /etc/os-release");
-      while (fgets(buffer, BUFFER_SIZE, os_release) &&
-             !(sscanf(buffer, "\nID=\"%s\"", user_info->os_name) ||
-               sscanf(buffer, "\nID=%s", user_info->os_name)))
-        ;
-      // sometimes for some reason sscanf reads the last '\"' too
-      int os_name_len = strlen(user_info->os_name);
-      if (user_info->os_name[os_name_len - 1] == '\"') {
-        user_info->os_name[os_name_len - 1] = '\0';
-      }
+      sprintf(user_info->os_name, "%s", os_id);
       // trying to detect amogos because in its os-release file ID value is just "debian", will be removed when amogos will have an os-release file with ID=amogos
       if (strcmp(user_info->os_name, "debian") == 0 ||
           strcmp(user_info->os_name, "raspbian") == 0) {
@@ -645,22 +2634,9 @@ void get_info(struct flags flags, struct info* user_info) {
       closedir(system_priv_app);
       if (flags.os) sprintf(user_info->os_name, "android");
       LOG_V(user_info->os_name);
-      if (flags.user) {
-        // username
-        FILE* whoami = popen("whoami", "r");
-        if (fscanf(whoami, "%s", user_info->user) == 3) {
-        }
-        LOG_V(user_info->user);
-        pclose(whoami);
-      }
     } else if (library) { // Apple
       closedir(library);
 #ifdef __APPLE__
-      if (flags.cpu) {
-        sysctlbyname("machdep.cpu.brand_string", &cpu_buffer, &cpu_buffer_len, NULL,
-                     0); // cpu name
-        sprintf(user_info->cpu_model, "%s", cpu_buffer);
-      }
       if (flags.os) {
   #ifndef __IPHONE__
         sprintf(user_info->os_name, "macos");
@@ -672,8 +2648,33 @@ void get_info(struct flags flags, struct info* user_info) {
     } else // if no option before is working, the system is unknown
       sprintf(user_info->os_name, "unknown");
   }
-#ifndef __BSD__
+#ifdef _WIN32
+  if (flags.os) sprintf(user_info->os_name, "windows");
+#endif
+  ((struct os_varg*)argp)->unavailable = !user_info->os_name[0];
+  return 0;
+}
+
+// Retrieves system information
+// gets the info that is not collected by a task and prepares the collection of the rest, finished (if not NULL) gets
+// the fields of every collector as soon as it is done. returns NULL if it is out of memory
+static struct collection* start_collection(struct flags flags, struct info* user_info, void (*finished)(unsigned fields, enum fetch_error error, void* arg), void* finished_arg) {
+  struct collection* collection = calloc(1, sizeof(*collection));
+  user_info->timed_out          = 0;
+  if (!collection) {
+    LOG_E("no memory to collect the info");
+    return NULL;
+  }
+  get_twidth(user_info);
+  // os version, cpu and board info
+  struct file_batch* files = &collection->files; // read at once, before the collectors need them
+  if (flags.os) batch_add(files, "/etc/os-release", 4096);
+  if (flags.ram) batch_add(files, "/proc/meminfo", 4096);
+#ifdef __linux__
+  for (size_t i = 0; flags.model && i < sizeof(dmi_model_paths) / sizeof(dmi_model_paths[0]); i++) batch_add(files, dmi_model_paths[i], BUFFER_SIZE);
+  if (flags.model) batch_add(files, "/proc/device-tree/model", BUFFER_SIZE);
 #endif
+  read_batch(files);
 #ifndef _WIN32
   // getting username and hostname
   if (flags.user) {
@@ -687,7 +2688,6 @@ void get_info(struct flags flags, struct info* user_info) {
     else
       sprintf(user_info->user, "%s", tmp_user);
     LOG_V(user_info->user);
-    if (os_release) fclose(os_release);
   }
   if (flags.shell) {
     LOG_I("getting shell");
@@ -704,9 +2704,10 @@ void get_info(struct flags flags, struct info* user_info) {
     LOG_V(user_info->shell);
   }
 #else  // if _WIN32
+  char buffer[BUFFER_SIZE]; // line buffer
   // cpu name
   if (flags.cpu) {
-    cpuinfo = popen("wmic cpu get caption", "r");
+    FILE* cpuinfo = popen("wmic cpu get caption", "r");
     while (fgets(buffer, BUFFER_SIZE, cpuinfo)) {
       if (strstr(buffer, "Caption") != 0)
         continue;
@@ -716,6 +2717,7 @@ void get_info(struct flags flags, struct info* user_info) {
         break;
       }
     }
+    pclose(cpuinfo);
   }
   // username
   if (flags.user) {
@@ -742,34 +2744,303 @@ void get_info(struct flags flags, struct info* user_info) {
   }
 #endif // _WIN32
 
-#ifdef _WIN32
-  if (flags.os) sprintf(user_info->os_name, "windows");
-#endif
+  if (finished) {
+    finished(FETCH_USER, user_info->user[0] ? FETCH_OK : FETCH_UNAVAILABLE, finished_arg);
+    finished(FETCH_SHELL, user_info->shell[0] ? FETCH_OK : FETCH_UNAVAILABLE, finished_arg);
+  }
   get_sys(user_info);
-  // are threads overpowered? nah
-  void* (*fnptrs[])(void*) = {get_cpu, get_ram, get_gpu, get_res, get_pkg, get_model, get_ker, get_upt};
-  struct thread_varg args =
-      (struct thread_varg){buffer,
-                           user_info,
-                           cpuinfo,
-                           {flags.cpu, flags.ram, flags.gpu, flags.resolution, flags.pkgs, flags.model, flags.kernel, flags.uptime}};
-#define THREAD_COUNT 8
-#ifndef _WIN32
-  pthread_t tids[THREAD_COUNT] = {0};
-#endif
-  for (int i = 0; i < THREAD_COUNT; i++) {
-    LOG_I("STARTING thread %d", i);
-#ifdef _WIN32
-    fnptrs[i](&args);
+
+  // collectors run as tasks on a small pool, each one with its own line buffer, writing to a copy of the info
+#ifndef _WIN32
+  long long deadline = user_info->deadline > 0 ? now_ms() + user_info->deadline : 0;
+#else
+  long long deadline = 0;
+#endif
+  memcpy(&collection->work, user_info, sizeof(collection->work)); // some collectors add to the values already there
+  struct collector_task* tasks = collection->tasks;
+  collection->os_args          = (struct os_varg){&collection->work, files, flags, false};
+  tasks[0]                     = (struct collector_task){.run = get_os, .arg = &collection->os_args, .fields = FETCH_OS, .unavailable = &collection->os_args.unavailable};
+  int task_count               = 1;
+  void* (*collectors[])(void*) = {get_cpu, get_ram, get_gpu, get_res, get_pkg, get_model, get_ker, get_upt};
+  bool enabled[]               = {flags.cpu, flags.ram, flags.gpu, flags.resolution, flags.pkgs, flags.model, flags.kernel, flags.uptime};
+  unsigned fields[]            = {FETCH_CPU, FETCH_RAM, FETCH_GPU, FETCH_RESOLUTION, FETCH_PKGS, FETCH_MODEL, FETCH_KERNEL, FETCH_UPTIME};
+  for (int i = 0; i < 8; i++) {
+    if (!enabled[i]) continue;
+    struct collector_task* task = &tasks[task_count++];
+    task->run                   = collectors[i];
+    task->deps                  = collectors[i] == get_gpu ? 1 << 0 : 0; // gpu detection needs the os name
+    task->fields                = fields[i];
+    task->args                  = (struct thread_varg){task->scratch, &collection->work, {false}, files, deadline, false};
+    task->args.thread_flags[i]  = true;
+    task->arg                   = &task->args;
+    task->unavailable           = &task->args.unavailable;
+  }
+  collection->user_info    = user_info;
+  collection->count        = task_count;
+  collection->deadline     = deadline;
+  collection->finished     = finished;
+  collection->finished_arg = finished_arg;
+  return collection;
+}
+
+// collects the info, calling finished (if not NULL) with the fields of every collector as soon as it is done
+static void collect_info(struct flags flags, struct info* user_info, void (*finished)(unsigned fields, enum fetch_error error, void* arg), void* finished_arg) {
+  struct collection* collection = start_collection(flags, user_info, finished, finished_arg);
+  if (collection) run_tasks(collection);
+}
+
+void get_info(struct flags flags, struct info* user_info) { collect_info(flags, user_info, NULL, NULL); }
+
+#define FETCH_FIELDS 11
+
+struct fetch_context {
+  struct info info;
+  enum fetch_error errors[FETCH_FIELDS]; // recorded by the collectors when they are done
+#ifndef _WIN32
+  // collection started by fetch_start
+  bool running;
+  unsigned requested, delivered, completed; // fields asked for, passed to the callback, whose collector is done
+  #ifdef __linux__
+  struct collection* collection; // its tasks run on the thread of the caller, in fetch_start and fetch_drain
+  struct command_table commands; // commands.poll_fd is the fd returned by fetch_start
+  int event_fd;                  // in commands.poll_fd, readable when fetch_start collected fields
+  int timer_fd;                  // in commands.poll_fd, expires when the next command has to be killed
+  #else
+  int event_fds[2]; // pipe made readable once the fields are collected
+  #endif
+#endif
+};
+
+struct fetch_context* fetch_create(int api_version) {
+  if (api_version != LIBFETCH_API_VERSION) return NULL;
+  return calloc(1, sizeof(struct fetch_context));
+}
+
+// sets the outcome of the fields done by a collector, those that were not requested are left alone
+static void record_fields(unsigned fields, enum fetch_error error, void* arg) {
+  struct fetch_context* context = arg;
+  for (int i = 0; i < FETCH_FIELDS; i++)
+    if (fields >> i & 1 && context->errors[i] != FETCH_NOT_REQUESTED) context->errors[i] = error;
+}
+
+// requested fields are unavailable until a collector records them, there is none for some of them on some systems
+static void reset_errors(struct fetch_context* context, unsigned fields) {
+  for (int i = 0; i < FETCH_FIELDS; i++) context->errors[i] = fields >> i & 1 ? FETCH_UNAVAILABLE : FETCH_NOT_REQUESTED;
+}
+
+// the flags of the FETCH_* fields, which are in the same order
+static struct flags fields_flags(unsigned fields) {
+  struct flags flags = {0};
+  for (int i = 0; i < FETCH_FIELDS; i++) ((bool*)&flags)[i] = fields >> i & 1;
+  return flags;
+}
+
+unsigned fetch_collect(struct fetch_context* context, unsigned fields, int deadline) {
+  struct info* info = &context->info;
+  memset(info, 0, sizeof(*info));
+  info->deadline = deadline;
+  reset_errors(context, fields);
+  collect_info(fields_flags(fields), info, record_fields, context);
+  unsigned failed = 0;
+  for (int i = 0; i < FETCH_FIELDS; i++)
+    if (context->errors[i] > FETCH_NOT_REQUESTED) failed |= 1u << i;
+  return failed;
+}
+
+#ifdef __linux__
+// records the fields of a task of fetch_start that is done, fetch_drain delivers them
+static void complete_fields(unsigned fields, enum fetch_error error, void* arg) {
+  struct fetch_context* context = arg;
+  record_fields(fields, error, context);
+  context->completed |= fields;
+}
+
+// runs the tasks of fetch_start whose dependencies are done and that wait for no command: a task that needs the output
+// of a command that is not done is run again from the start once it is, the fields it wrote are put back before
+static void run_async_tasks(struct fetch_context* context) {
+  struct collection* collection = context->collection;
+  struct command_table* table   = &context->commands;
+  async_commands                = table;
+  for (int i = 0; i < collection->count; i++) { // tasks are in dependency order
+    struct collector_task* task = &collection->tasks[i];
+    bool waiting                = collection->done & 1U << i || (task->deps & collection->done) != task->deps;
+    for (int j = 0; j < table->count && !waiting; j++) waiting = table->commands[j].fd >= 0 && table->commands[j].waiting & 1U << i;
+    if (waiting) continue;
+    info_copy_fields(&collection->work, &context->info, task->fields);
+    *task->unavailable = false;
+    table->task        = i;
+    table->pending     = false;
+    command_killed     = false;
+    task->run(task->arg);
+    if (table->pending) continue;
+    info_copy_fields(&context->info, &collection->work, task->fields);
+    collection->done |= 1U << i;
+    collection->finished(task->fields, task_error(collection, task), context);
+  }
+  async_commands = NULL;
+}
+
+// reads what the commands of fetch_start printed, kills those past their time and reaps those that exited
+static void poll_commands(struct command_table* table) {
+  long long now = now_ms();
+  for (int i = 0; i < table->count; i++) {
+    struct async_command* command = &table->commands[i];
+    if (command->pid && waitpid(command->pid, NULL, WNOHANG) != 0) command->pid = 0;
+    if (command->fd < 0) continue;
+    char discard[256]; // keep draining the pipe once output is full
+    ssize_t n;
+    while ((n = (size_t)command->read_len + 1 < command->size ? read(command->fd, command->output + command->read_len, command->size - command->read_len - 1)
+                                                              : read(command->fd, discard, sizeof(discard))) > 0)
+      if ((size_t)command->read_len + 1 < command->size) command->read_len += n;
+    bool done = n == 0 || errno != EAGAIN;
+    if (!done && command->kill_at && now >= command->kill_at) {
+      LOG_W("'%s' timed out, killing it", command->command);
+      if (kill(-command->pid, SIGKILL) != 0) kill(command->pid, SIGKILL); // reaped by a later drain
+      command->read_len = -1;
+      done              = true;
+    }
+    if (!done) continue;
+    epoll_ctl(table->poll_fd, EPOLL_CTL_DEL, command->fd, NULL);
+    close(command->fd);
+    command->fd = -1;
+  }
+}
+
+// arms the timer of fetch_start for the next command to kill
+static void arm_timer(struct fetch_context* context) {
+  long long next = 0;
+  for (int i = 0; i < context->commands.count; i++) {
+    struct async_command* command = &context->commands.commands[i];
+    if (command->fd >= 0 && command->kill_at && (!next || command->kill_at < next)) next = command->kill_at;
+  }
+  struct itimerspec until = {{0, 0}, {next / 1000, next % 1000 * 1000000}}; // a zero time disarms it
+  timerfd_settime(context->timer_fd, TFD_TIMER_ABSTIME, &until, NULL);
+}
+
+// ends the collection of fetch_start, killing the commands still running
+static void stop_async(struct fetch_context* context) {
+  for (int i = 0; i < context->commands.count; i++) {
+    struct async_command* command = &context->commands.commands[i];
+    if (command->fd >= 0) close(command->fd);
+    if (command->pid && waitpid(command->pid, NULL, WNOHANG) == 0) kill_command(command->pid);
+    free(command->command);
+    free(command->output);
+  }
+  int fds[] = {context->commands.poll_fd, context->event_fd, context->timer_fd};
+  for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+    if (fds[i] >= 0) close(fds[i]);
+  context->commands.count = 0;
+  free(context->collection);
+  context->collection = NULL;
+  context->running    = false;
+}
+
+// reads the counter of an eventfd or a timerfd, if it is set
+static void clear_fd(int fd) {
+  uint64_t count;
+  while (read(fd, &count, sizeof(count)) > 0) continue;
+}
+#endif
+
+int fetch_start(struct fetch_context* context, unsigned fields, int deadline) {
+#ifndef _WIN32
+  if (context->running) return -1;
+  memset(&context->info, 0, sizeof(context->info));
+  reset_errors(context, fields);
+  context->info.deadline = deadline;
+  context->requested     = fields & FETCH_ALL;
+  context->delivered     = 0;
+  context->completed     = 0;
+  #ifdef __linux__
+  memset(&context->commands, 0, sizeof(context->commands));
+  context->collection       = NULL;
+  context->running          = true;
+  context->commands.poll_fd = epoll_create1(EPOLL_CLOEXEC);
+  context->event_fd         = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC); // the first drain delivers what is collected here
+  context->timer_fd         = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  struct epoll_event event  = {.events = EPOLLIN};
+  if (context->commands.poll_fd < 0 || context->event_fd < 0 || context->timer_fd < 0 ||
+      epoll_ctl(context->commands.poll_fd, EPOLL_CTL_ADD, context->event_fd, &event) != 0 ||
+      epoll_ctl(context->commands.poll_fd, EPOLL_CTL_ADD, context->timer_fd, &event) != 0 ||
+      !(context->collection = start_collection(fields_flags(fields), &context->info, complete_fields, context))) {
+    stop_async(context);
+    return -1;
+  }
+  run_async_tasks(context);
+  arm_timer(context);
+  return context->commands.poll_fd;
+  #else
+  // commands can only be run without blocking on linux, here the collection is done before returning
+  if (pipe(context->event_fds) != 0) return -1;
+  for (int i = 0; i < 2; i++) fcntl(context->event_fds[i], F_SETFD, FD_CLOEXEC);
+  fcntl(context->event_fds[0], F_SETFL, O_NONBLOCK);
+  collect_info(fields_flags(fields), &context->info, record_fields, context);
+  if (write(context->event_fds[1], "", 1) < 0) {
+    LOG_E("could not signal the end of the collection");
+  }
+  context->running = true;
+  return context->event_fds[0];
+  #endif
 #else
-    pthread_create(&tids[i], NULL, fnptrs[i], &args);
+  (void)context;
+  (void)fields;
+  (void)deadline;
+  return -1;
 #endif
+}
+
+bool fetch_drain(struct fetch_context* context, fetch_callback callback, void* arg) {
+#ifndef _WIN32
+  if (!context->running) return true;
+  #ifdef __linux__
+  clear_fd(context->event_fd);
+  clear_fd(context->timer_fd);
+  poll_commands(&context->commands);
+  run_async_tasks(context);
+  arm_timer(context);
+  unsigned completed = context->completed;
+  bool finished      = context->collection->done == (1U << context->collection->count) - 1;
+  if (finished) stop_async(context);
+  #else
+  unsigned completed = context->completed;
+  bool finished      = true;
+  close(context->event_fds[0]);
+  close(context->event_fds[1]);
+  context->running = false;
+  #endif
+  if (finished) completed |= context->requested; // a field without a collector is done too
+  for (int i = 0; i < FETCH_FIELDS; i++) {
+    unsigned field = 1U << i;
+    if (!(completed & context->requested & field) || context->delivered & field) continue;
+    context->delivered |= field;
+    if (callback) callback(context, field, context->errors[i], arg);
   }
+  return finished;
+#else
+  (void)context;
+  (void)callback;
+  (void)arg;
+  return true;
+#endif
+}
+
+const struct info* fetch_info(const struct fetch_context* context) { return &context->info; }
+
+enum fetch_error fetch_field_error(const struct fetch_context* context, enum fetch_field field) {
+  for (int i = 0; i < FETCH_FIELDS; i++)
+    if ((unsigned)field == 1u << i) return context->errors[i];
+  return FETCH_NOT_REQUESTED;
+}
+
+void fetch_destroy(struct fetch_context* context) {
 #ifndef _WIN32
-  for (int i = 0; i < THREAD_COUNT; i++) {
-    if (tids[i] != 0) pthread_join(tids[i], NULL);
-    LOG_I("JOINING thread %d", i);
+  if (context && context->running) {
+  #ifdef __linux__
+    stop_async(context);
+  #else
+    fetch_drain(context, NULL, NULL);
+  #endif
   }
 #endif
-  fclose(cpuinfo);
+  free(context);
 }
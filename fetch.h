@@ -55,6 +55,7 @@ bool* get_verbose_handle();
     }
 #else
   #define LOG_I(format, ...)
+  #define LOG_W(format, ...)
   #define LOG_E(format, ...)
   #define LOG_V(var)
   #define LOG(type, format, ...)
@@ -98,6 +99,22 @@ bool* get_verbose_handle();
   #endif // _WIN32
 #endif
 
+#define MAX_MONITORS 16
+#define MAX_GPUS 32
+#define GPU_ARENA_SIZE 4096 // bytes shared by all the gpu names
+
+// mode of a connected monitor
+struct monitor {
+  int width, height, refresh_rate; // refresh_rate is 0 if unknown
+};
+
+// package managers counted by get_pkg
+enum pkg_scope {
+  PKGS_ALL,
+  PKGS_SYSTEM, // only those shared by every user
+  PKGS_USER    // only those in the home of the user (flatpak --user, guix, homebrew), added to the packages already in the info
+};
+
 // info that will be printed with the logo
 struct info {
   char user[128],  // username
@@ -106,13 +123,22 @@ struct info {
       model[256],  // model name
       kernel[256], // kernel name (linux 5.x-whatever)
       os_name[64], // os name (arch linux, windows, mac os)
-      cpu_model[256], gpu_model[256][256],
+      cpu_model[256],
       pkgman_name[64], // package managers string
       image_name[128];
   int target_width, // for the truncate_str function
       screen_width, screen_height, ram_total, ram_used,
-      pkgs; // full package count
+      pkgs, // full package count
+      monitor_count,
+      deadline; // milliseconds get_info can wait for the collectors, 0 waits for all of them
+  unsigned timed_out; // FETCH_* fields get_info stopped waiting for at the deadline, they are left as they were
+  enum pkg_scope pkg_scope;
+  struct monitor monitors[MAX_MONITORS];
   long uptime;
+  // gpu names are offsets in gpu_arena instead of pointers, so a copy of the struct is still valid
+  int gpu_count;
+  unsigned short gpu_names[MAX_GPUS], gpu_arena_used;
+  char gpu_arena[GPU_ARENA_SIZE];
 
 #ifndef _WIN32
   struct utsname sys_var;
@@ -137,8 +163,10 @@ struct info {
 struct thread_varg {
   char* buffer;
   struct info* user_info;
-  FILE* cpuinfo;
   bool thread_flags[8];
+  struct file_batch* files; // files read ahead by get_info, can be NULL
+  long long deadline;       // commands still running at this time are killed, 0 waits for them
+  bool unavailable;         // set by the collector when this system does not have the info
 };
 
 // decide what info should be retrieved
@@ -146,6 +174,26 @@ struct flags {
   bool user, shell, model, kernel, os, cpu, gpu, resolution, ram, pkgs, uptime;
 };
 
+// called by scan_keys with the index of the key found and its value
+typedef void (*scan_fn)(int key, const char* value, size_t len, void* arg);
+int scan_keys(const char* data, size_t len, char separator, const char* const keys[], int key_count, scan_fn found, void* arg);
+int scan_file(const char* path, char* buffer, size_t len, char separator, const char* const keys[], int key_count, scan_fn found, void* arg);
+
+// cache files are kept in a local directory keyed by host, dir replaces it (from the next cached file on)
+void set_cache_dir(const char* dir);
+bool get_cache_path(const char* name, char* path, size_t len);
+
+// name of the gpu i, NULL if there are not that many
+const char* info_gpu(const struct info* user_info, int i);
+// stores name as the gpu i (gpu_count adds one), false if there is no room left
+bool info_set_gpu(struct info* user_info, int i, const char* name, size_t len);
+void info_clear_gpus(struct info* user_info);
+// copies the FETCH_* fields of src to dst
+void info_copy_fields(struct info* dst, const struct info* src, unsigned fields);
+// makes a struct info read from another process safe to print
+void info_sanitize(struct info* user_info);
+
+void get_twidth(struct info*);
 void get_sys(struct info*);
 void* get_ram(void*);
 void* get_gpu(void*);
@@ -161,4 +209,50 @@ void* get_upt(void*);
 // Retrieves system information
 void get_info(struct flags, struct info* user_info);
 
+// reentrant api: every thread can collect with its own context at the same time
+#define LIBFETCH_API_VERSION 1
+
+// fields collected by fetch_collect, in the order of struct flags
+enum fetch_field {
+  FETCH_USER       = 1 << 0, // user and host name
+  FETCH_SHELL      = 1 << 1,
+  FETCH_MODEL      = 1 << 2,
+  FETCH_KERNEL     = 1 << 3,
+  FETCH_OS         = 1 << 4,
+  FETCH_CPU        = 1 << 5,
+  FETCH_GPU        = 1 << 6,
+  FETCH_RESOLUTION = 1 << 7,
+  FETCH_RAM        = 1 << 8,
+  FETCH_PKGS       = 1 << 9,
+  FETCH_UPTIME     = 1 << 10,
+  FETCH_ALL        = (1 << 11) - 1
+};
+
+// outcome of each field in the last fetch_collect
+enum fetch_error {
+  FETCH_OK,            // collected
+  FETCH_NOT_REQUESTED, // not in the fields passed to fetch_collect
+  FETCH_UNAVAILABLE,   // not found on this system
+  FETCH_TIMEOUT        // still being collected when the deadline passed
+};
+
+struct fetch_context;
+// returns NULL if the library does not support api_version (LIBFETCH_API_VERSION of the caller) or it is out of memory
+struct fetch_context* fetch_create(int api_version);
+// collects the fields (FETCH_* bits), waiting for commands at most deadline milliseconds (0 for no limit), returns the fields that failed
+unsigned fetch_collect(struct fetch_context* context, unsigned fields, int deadline);
+// starts collecting the fields on the calling thread without waiting for commands, returns a fd to poll that becomes
+// readable as they finish (-1 on error). on linux no thread is started, elsewhere the fields are collected before it returns
+int fetch_start(struct fetch_context* context, unsigned fields, int deadline);
+// called by fetch_drain for every field collected since the last drain
+typedef void (*fetch_callback)(struct fetch_context* context, enum fetch_field field, enum fetch_error error, void* arg);
+// runs the collectors whose commands are done and delivers the fields collected so far, returns true when all of them
+// were delivered and the fd of fetch_start is closed
+bool fetch_drain(struct fetch_context* context, fetch_callback callback, void* arg);
+// info collected by the last fetch_collect or fetch_start (a field is complete once delivered), valid until the next one
+const struct info* fetch_info(const struct fetch_context* context);
+enum fetch_error fetch_field_error(const struct fetch_context* context, enum fetch_field field);
+// kills the commands of a fetch_start collection that is still running
+void fetch_destroy(struct fetch_context* context);
+
 #endif // _FETCH_H_
@@ -0,0 +1,39 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// helpers shared by the benchmarks of make bench, each one compares the old way of getting some info with the current one
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static long long bench_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// number of runs given as the first argument, or runs
+static int bench_runs(int argc, char** argv, int runs) { return argc > 1 && atoi(argv[1]) > 0 ? atoi(argv[1]) : runs; }
+
+// prints the average time of a run of both versions
+static void bench_report(const char* name, long long old_ns, long long new_ns, int runs) {
+  printf("%-28s old %10.2f us   new %10.2f us   %6.1fx\n", name, old_ns / 1e3 / runs, new_ns / 1e3 / runs, new_ns ? (double)old_ns / new_ns : 0);
+}
+
+#endif // _BENCH_H_
@@ -0,0 +1,70 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// the native package database readers against the package manager commands piped to wc -l they replaced
+// only the package managers installed on this system are timed
+// usage: bench_pkgs [runs]
+
+#include "../fetch.c"
+#include "bench.h"
+
+#define COMMAND_RUNS 10 // the commands take up to seconds, they run fewer times
+
+int main(int argc, char** argv) {
+#if defined(__linux__) || defined(__BSD__)
+  int runs                         = bench_runs(argc, argv, 1000);
+  struct package_manager pkgmans[] = {
+      {PKGPATH "apt", "apt list --installed 2> /dev/null | wc -l", "(apt)", count_dpkg, "/var/lib/dpkg/status", NULL, false},
+      {PKGPATH "apk", "apk info 2> /dev/null | wc -l", "(apk)", count_apk, "/lib/apk/db/installed", NULL, false},
+  #ifndef __OPENBSD__
+      {PKGPATH "qlist", "qlist -I 2> /dev/null | wc -l", "(emerge)", count_portage, "/var/db/pkg", NULL, false},
+  #endif
+      {PKGPATH "flatpak", "flatpak list --system 2> /dev/null | wc -l", "(flatpak)", count_flatpak, "/var/lib/flatpak", NULL, false},
+      {PKGPATH "flatpak", "flatpak list --user 2> /dev/null | wc -l", "(flatpak)", count_flatpak, "~/.local/share/flatpak", NULL, true},
+      {PKGPATH "snap", "snap list 2> /dev/null | wc -l", "(snap)", count_snap, "/var/lib/snapd/snaps", NULL, false},
+      {PKGPATH "guix", "guix package --list-installed 2> /dev/null | wc -l", "(guix)", count_guix, "~/.guix-profile/manifest", NULL, true},
+      {PKGPATH "nix-store", "nix-store -q --requisites /run/current-system/sw 2> /dev/null | wc -l", "(nix)", count_nix, "/nix/var/nix/db/db.sqlite", NULL, false},
+      {PKGPATH "pacman", "pacman -Qq 2> /dev/null | wc -l", "(pacman)", count_pacman, "/var/lib/pacman/local", NULL, false},
+      {PKGPATH "pkg", "pkg info 2>/dev/null | wc -l", "(pkg)", count_pkgng, "/var/db/pkg/local.sqlite", NULL, false},
+  #ifdef __OPENBSD__
+      {PKGPATH "pkg_info", "pkg_info 2>/dev/null | wc -l | sed \"s/ //g\"", "(pkg)", count_pkg_info, "/var/db/pkg", NULL, false},
+  #endif
+      {PKGPATH "rpm", "rpm -qa --last 2> /dev/null | wc -l", "(rpm)", count_rpm, "/var/lib/rpm/rpmdb.sqlite", NULL, false},
+      {PKGPATH "xbps-query", "xbps-query -l 2> /dev/null | wc -l", "(xbps)", count_xbps, "/var/db/xbps/pkgdb-0.38.plist", NULL, false}};
+  int timed = 0;
+  for (size_t i = 0; i < sizeof(pkgmans) / sizeof(pkgmans[0]); i++) {
+    struct package_manager* current = &pkgmans[i];
+    if (access(current->command_path, X_OK) != 0 || current->count_native(current->db_path) < 0) continue;
+    char output[64];
+    int command_count = -1, native_count = -1;
+    long long start = bench_ns();
+    for (int j = 0; j < COMMAND_RUNS; j++)
+      if (run_command(current->command_string, output, sizeof(output), -1) < 0 || sscanf(output, "%d", &command_count) != 1) command_count = -1;
+    long long old_ns = (bench_ns() - start) * runs / COMMAND_RUNS; // as if they ran as many times as the readers
+    start            = bench_ns();
+    for (int j = 0; j < runs; j++) native_count = current->count_native(current->db_path);
+    char name[64];
+    snprintf(name, sizeof(name), "%s %d/%d", current->pkgman_name, command_count, native_count); // header lines of a command are counted too
+    bench_report(name, old_ns, bench_ns() - start, runs);
+    timed++;
+  }
+  if (!timed) printf("none of the supported package managers is installed\n");
+#else
+  (void)argc;
+  (void)argv;
+  printf("the package databases are only read natively on linux and BSD\n");
+#endif
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// scan_file against the fgets and sscanf loops it replaced
+// usage: bench_scan [runs]
+
+#include "../fetch.c"
+#include "bench.h"
+
+// the /proc/meminfo loop of get_ram before scan_file
+static long old_meminfo() {
+  char buffer[BUFFER_SIZE];
+  int memtotal = 0, shmem = 0, memfree = 0, buffers = 0, cached = 0, sreclaimable = 0;
+  FILE* meminfo = fopen("/proc/meminfo", "r");
+  while (meminfo && fgets(buffer, BUFFER_SIZE, meminfo)) {
+    sscanf(buffer, "MemTotal:       %d", &memtotal);
+    sscanf(buffer, "Shmem:             %d", &shmem);
+    sscanf(buffer, "MemFree:        %d", &memfree);
+    sscanf(buffer, "Buffers:          %d", &buffers);
+    sscanf(buffer, "Cached:          %d", &cached);
+    sscanf(buffer, "SReclaimable:     %d", &sreclaimable);
+  }
+  if (meminfo) fclose(meminfo);
+  return ((memtotal + shmem) - (memfree + buffers + cached + sreclaimable)) / 1024;
+}
+
+static long new_meminfo() {
+  static const char* const meminfo_keys[] = {"MemTotal", "Shmem", "MemFree", "Buffers", "Cached", "SReclaimable"};
+  long meminfo_values[6]                  = {0};
+  char meminfo_buffer[8192];
+  scan_file("/proc/meminfo", meminfo_buffer, sizeof(meminfo_buffer), ':', meminfo_keys, 6, store_long, meminfo_values);
+  return ((meminfo_values[0] + meminfo_values[1]) - (meminfo_values[2] + meminfo_values[3] + meminfo_values[4] + meminfo_values[5])) / 1024;
+}
+
+// the /etc/os-release loop of get_os before scan_file
+static char old_os_release() {
+  char buffer[BUFFER_SIZE], os_name[64] = "";
+  FILE* os_release = fopen("/etc/os-release", "r");
+  while (os_release && fgets(buffer, BUFFER_SIZE, os_release) &&
+         !(sscanf(buffer, "\nID=\"%63s\"", os_name) || sscanf(buffer, "\nID=%63s", os_name)))
+    ;
+  if (os_release) fclose(os_release);
+  return os_name[0];
+}
+
+static char new_os_release() {
+  static const char* const os_release_keys[] = {"ID"};
+  char os_release_buffer[4096], os_name[64] = "";
+  scan_file("/etc/os-release", os_release_buffer, sizeof(os_release_buffer), '=', os_release_keys, 1, store_unquoted, os_name);
+  return os_name[0];
+}
+
+int main(int argc, char** argv) {
+  int runs           = bench_runs(argc, argv, 20000);
+  volatile long sink = 0; // keeps the parsed values alive
+  long long start    = bench_ns();
+  for (int i = 0; i < runs; i++) sink += old_meminfo();
+  long long old_ns = bench_ns() - start;
+  start            = bench_ns();
+  for (int i = 0; i < runs; i++) sink += new_meminfo();
+  bench_report("/proc/meminfo", old_ns, bench_ns() - start, runs);
+
+  start = bench_ns();
+  for (int i = 0; i < runs; i++) sink += old_os_release();
+  old_ns = bench_ns() - start;
+  start  = bench_ns();
+  for (int i = 0; i < runs; i++) sink += new_os_release();
+  bench_report("/etc/os-release", old_ns, bench_ns() - start, runs);
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// uwufy against the replace loops it replaced, on typical names and logo lines
+// usage: bench_uwufy [runs]
+
+#include "../fetch.c"
+#define main uwufetch_main
+#include "../uwufetch.c"
+#undef main
+#include "bench.h"
+#include "old_uwufy.h"
+
+// times both versions on str, returns 1 if they give a different output
+static int bench_table(const char* name, const char* const rules[][2], int rule_count, bool ignore_case, const char* str, int runs) {
+  static struct uwufier uwufier;
+  char old[1024], new[1024];
+  volatile char sink = 0; // keeps the output alive
+  long long start    = bench_ns();
+  for (int i = 0; i < runs; i++) {
+    strcpy(old, str);
+    old_uwufy(rules, rule_count, ignore_case, old);
+    sink += old[0];
+  }
+  long long old_ns = bench_ns() - start;
+  start            = bench_ns();
+  build_uwufier(&uwufier, rules, rule_count, ignore_case); // once per table in uwufetch too, it is counted once here
+  for (int i = 0; i < runs; i++) {
+    uwufy(&uwufier, str, new, sizeof(new));
+    sink += new[0];
+  }
+  bench_report(name, old_ns, bench_ns() - start, runs);
+  if (strcmp(old, new) == 0) return 0;
+  printf("different output for \"%s\"\n  old \"%s\"\n  new \"%s\"\n", str, old, new);
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  int runs = bench_runs(argc, argv, 200000);
+  int different =
+      bench_table("gpu and cpu names", hw_rules, sizeof(hw_rules) / sizeof(hw_rules[0]), true,
+                  "Advanced Micro Devices, Inc. [AMD/ATI] Lucienne Radeon Graphics Intel(R) Core(TM) i7 CPU", runs);
+  different += bench_table("package managers", pkgman_rules, sizeof(pkgman_rules) / sizeof(pkgman_rules[0]), true,
+                           "1024 (pacman), 38 (flatpak), 12 (brew-cellar), 5 (snap)", runs);
+  different += bench_table("logo line", color_rules, sizeof(color_rules) / sizeof(color_rules[0]), false,
+                           "{PINK}  ,--.  {WHITE}(o.o){PINK}  .--,  {NORMAL}", runs);
+  return different != 0;
+}
@@ -0,0 +1,46 @@
+#!/bin/bash
+# launches many uwufetch instances at once against a shared cache (like tmux restoring its panes or a burst of ssh logins)
+# and reports their latency and the reads that did not match the cache written before the storm
+# usage: cache_stress.sh [runs] [uwufetch binary]
+RUNS=${1:-300}
+UWUFETCH=$(realpath "${2:-./uwufetch}")
+export HOME=$(mktemp -d)
+trap 'rm -rf "$HOME"' EXIT
+mkdir -p "$HOME/.config/uwufetch"
+echo "cache_dir=$HOME/cache" >"$HOME/.config/uwufetch/config"
+CACHE=$HOME/cache/uwufetch.cache
+
+# reference values, then a text cache so that the first readers have to collect everything again
+"$UWUFETCH" -w >/dev/null || exit 1
+"$UWUFETCH" -e >"$HOME/reference" || exit 1
+cp "$HOME/reference" "$CACHE"
+
+for i in $(seq "$RUNS"); do
+	(
+		# a writer every ten runs, the others read the cache
+		[ $((i % 10)) -eq 0 ] && mode=-w || mode=-r
+		start=$(date +%s%N)
+		"$UWUFETCH" $mode >/dev/null 2>&1
+		status=$?
+		end=$(date +%s%N)
+		echo $(((end - start) / 1000)) >>"$HOME/latency"
+		if [ $status -ne 0 ] || ! "$UWUFETCH" -e 2>/dev/null | cmp -s - "$HOME/reference"; then
+			echo "$i" >>"$HOME/corrupted"
+		fi
+	) &
+done
+wait
+
+sort -n "$HOME/latency" | awk -v runs="$RUNS" '
+	{ latency[NR] = $1 }
+	END {
+		printf "runs: %d\n", runs
+		printf "p50:  %.2f ms\n", latency[int(NR * 0.50 + 0.5)] / 1000
+		printf "p99:  %.2f ms\n", latency[int(NR * 0.99 + 0.5)] / 1000
+		printf "max:  %.2f ms\n", latency[NR] / 1000
+	}'
+corrupted=$(cat "$HOME/corrupted" 2>/dev/null | wc -l)
+echo "corrupted reads: $corrupted"
+leftovers=$(find "$HOME/cache" -name 'uwufetch.cache.*' | wc -l)
+echo "leftover temp files: $leftovers"
+[ "$corrupted" -eq 0 ] && [ "$leftovers" -eq 0 ]
@@ -0,0 +1,68 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// checks the native package counters against the commands they replaced, on the trees of scripts/fixtures/pkgs
+// the outputs of the commands that can not run here (flatpak, snap, guix, nix-store) were recorded next to the trees,
+// find runs on the brew tree. nix/db.sqlite is built from nix/db.sql.
+// usage: check_pkgs (from the root of the repository)
+
+#include "../fetch.c"
+
+#define FIXTURES "scripts/fixtures/pkgs/"
+
+// store path of the system profile in nix/db.sqlite
+static int count_nix_fixture(const char* path) { return count_nix_closure(path, "/nix/store/00000000000000000000000000000001-system-path"); }
+
+static const struct pkg_check {
+  const char* name;
+  int (*count)(const char* path);
+  const char* path;    // fixture read by the counter
+  const char* command; // prints what the replaced command prints on the fixture
+  int extra_lines;     // lines of that output that are not packages, left out on purpose by the counter
+} checks[] = {
+    // flatpak list prints no header when it does not write to a terminal, one line per app or runtime branch
+    {"flatpak", count_flatpak, FIXTURES "flatpak", "cat " FIXTURES "flatpak/list.out", 0},
+    // snap list always starts with a "Name Version Rev ..." header, which was counted as a package
+    {"snap", count_snap, FIXTURES "snap/snaps", "cat " FIXTURES "snap/list.out", 1},
+    // guix package --list-installed prints every output of the profile, the propagated inputs are not listed
+    {"guix", count_guix, FIXTURES "guix/manifest", "cat " FIXTURES "guix/list.out", 0},
+    // nix-store -q --requisites prints the closure including the profile itself
+    {"nix", count_nix_fixture, FIXTURES "nix/db.sqlite", "cat " FIXTURES "nix/requisites.out", 0},
+    // find -maxdepth 1 -type d also prints the Cellar directory itself, which was counted as a formula
+    {"brew-cellar", count_brew, "Cellar", "find " FIXTURES "brew/Cellar -maxdepth 1 -type d", 1},
+    // the same for the Caskroom directory, the hidden .metadata directories of the casks are one level deeper
+    {"brew-cask", count_brew, "Caskroom", "find " FIXTURES "brew/Caskroom -maxdepth 1 -type d", 1},
+};
+
+// lines printed by command, -1 if it can not run
+static int count_output(const char* command) {
+  FILE* output = popen(command, "r");
+  if (!output) return -1;
+  int lines = 0, c;
+  while ((c = fgetc(output)) != EOF) lines += c == '\n';
+  return pclose(output) == 0 ? lines : -1;
+}
+
+int main(void) {
+  int wrong = 0;
+  setenv("HOMEBREW_PREFIX", FIXTURES "brew", 1); // looked up before the usual prefixes
+  for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+    int counted = checks[i].count(checks[i].path), lines = count_output(checks[i].command);
+    bool same   = lines >= 0 && counted == lines - checks[i].extra_lines;
+    printf("%-12s counted %3d, command %3d lines - %d extra: %s\n", checks[i].name, counted, lines, checks[i].extra_lines, same ? "ok" : "WRONG");
+    wrong += !same;
+  }
+  return wrong != 0;
+}
@@ -0,0 +1,38 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// prints the slots of the distros table of uwufetch.c, so the lookups do not fill it at run time
+// usage: distro_slots > distro_slots.h
+
+#include "../distros.h"
+#include <stdio.h>
+
+static const char* const ids[] = {
+#define DISTRO(id, uwu_name, logo, group, color) id,
+    DISTROS
+#undef DISTRO
+};
+
+int main(void) {
+  unsigned char slots[DISTRO_SLOTS] = {0}; // index in ids + 1, 0 if empty
+  for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+    unsigned slot = distro_slot(ids[i]);
+    while (slots[slot]) slot = (slot + 1) & (DISTRO_SLOTS - 1);
+    slots[slot] = i + 1;
+  }
+  printf("// generated by scripts/distro_slots.c, do not edit\n");
+  for (int i = 0; i < DISTRO_SLOTS; i++) printf("%d,%s", slots[i], i % 16 == 15 ? "\n" : " ");
+  return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/sh
+# prints the ascii logos given as arguments as LOGO(name, width, height, text) rows for uwufetch.c
+# every {PLACEHOLDER} becomes the macro with its name, so the logos are expanded by the compiler
+# the width counts the columns of the widest line: {BLOCK}s and utf-8 characters are one column, colors none
+# usage: embed_logos.sh res/ascii/*.txt > logos.h
+echo "// generated by scripts/embed_logos.sh, do not edit"
+for logo in "$@"; do
+	last='$s/$/\\n"/'
+	[ -z "$(tail -c 1 "$logo")" ] || last='$s/$/"/' # the last line has no newline
+	printf 'LOGO("%s", %d, %d,\n' "$(basename "$logo" .txt)" "$(LC_ALL=C awk '{
+		gsub(/\{BLOCK(_VERTICAL)?\}/, "x"); gsub(/\{[A-Z_]*\}/, ""); gsub(/[\200-\277]/, "") # utf-8 continuation bytes
+		if (length($0) > width) width = length($0)
+	} END { print width + 0 }' "$logo")" "$(awk 'END { print NR }' "$logo")"
+	sed -e 's/\\/\\\\/g' -e 's/"/\\"/g' -e 's/{\([A-Z_]*\)}/" \1 "/g' -e 's/^/     "/' -e '$!s/$/\\n"/' -e "$last" "$logo"
+	echo ")"
+done
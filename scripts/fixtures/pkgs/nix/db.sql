@@ -0,0 +1,60 @@
+-- the tables of /nix/var/nix/db/db.sqlite read by count_nix, db.sqlite is built from this file with:
+-- sqlite3 db.sqlite < db.sql
+-- small pages and the unrelated paths give the tables interior pages, like a real store
+pragma page_size = 1024;
+
+create table ValidPaths (
+  id integer primary key autoincrement not null,
+  path text unique not null,
+  hash text not null,
+  registrationTime integer not null,
+  deriver text,
+  narSize integer,
+  ultimate integer,
+  sigs text,
+  ca text
+);
+
+create table Refs (
+  referrer integer not null,
+  reference integer not null,
+  primary key (referrer, reference),
+  foreign key (referrer) references ValidPaths(id) on delete cascade,
+  foreign key (reference) references ValidPaths(id) on delete restrict
+);
+
+insert into ValidPaths (id, path, hash, registrationTime) values
+  (1, '/nix/store/00000000000000000000000000000001-system-path', 'sha256:1', 1700000000),
+  (2, '/nix/store/00000000000000000000000000000002-bash-5.2-p15', 'sha256:2', 1700000000),
+  (3, '/nix/store/00000000000000000000000000000003-coreutils-9.3', 'sha256:3', 1700000000),
+  (4, '/nix/store/00000000000000000000000000000004-hello-2.12.1', 'sha256:4', 1700000000),
+  (5, '/nix/store/00000000000000000000000000000005-glibc-2.38-27', 'sha256:5', 1700000000),
+  (6, '/nix/store/00000000000000000000000000000006-readline-8.2p1', 'sha256:6', 1700000000),
+  (7, '/nix/store/00000000000000000000000000000007-acl-2.3.1', 'sha256:7', 1700000000),
+  (8, '/nix/store/00000000000000000000000000000008-ncurses-6.4', 'sha256:8', 1700000000),
+  (9, '/nix/store/00000000000000000000000000000009-attr-2.5.1', 'sha256:9', 1700000000),
+  (10, '/nix/store/00000000000000000000000000000010-libidn2-2.3.4', 'sha256:10', 1700000000),
+  (11, '/nix/store/00000000000000000000000000000011-libunistring-1.1', 'sha256:11', 1700000000),
+  (12, '/nix/store/00000000000000000000000000000012-gcc-12.3.0', 'sha256:12', 1700000000);
+
+-- paths of other profiles and of builds, outside the closure of the system
+with recursive filler(id) as (select 13 union all select id + 1 from filler where id < 150)
+insert into ValidPaths (id, path, hash, registrationTime)
+  select id, printf('/nix/store/%032d-unrelated-%d', id, id), printf('sha256:%d', id), 1700000000 from filler;
+
+-- the closure of system-path is 1 to 11, paths often refer to themselves
+insert into Refs (referrer, reference) values
+  (1, 2), (1, 3), (1, 4),
+  (2, 2), (2, 5), (2, 6),
+  (3, 5), (3, 7),
+  (4, 5),
+  (5, 5), (5, 10),
+  (6, 5), (6, 8),
+  (7, 9),
+  (8, 5),
+  (9, 5),
+  (10, 11),
+  (12, 5), (12, 10);
+
+with recursive filler(id) as (select 13 union all select id + 1 from filler where id < 150)
+insert into Refs (referrer, reference) select id, case when id % 3 then 5 else id - 1 end from filler;
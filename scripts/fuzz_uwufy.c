@@ -0,0 +1,145 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// checks that uwufy gives the same output as the replace loops it replaced, on random strings
+// usage: fuzz_uwufy [strings per table]
+// when words are glued together two patterns can overlap ("electronicpu"), the old loops then depended on the order of
+// the rules, uwufy replaces the leftmost match (the first rule wins when more start at the same character)
+
+#include "../fetch.c"
+#define main uwufetch_main
+#include "../uwufetch.c"
+#undef main
+#include "old_uwufy.h"
+
+// a string of patterns, replacements and random words, returns its length
+static size_t random_string(const char* const rules[][2], int rule_count, bool ignore_case, bool glued, char* str, size_t size) {
+  static const char* const separators[] = {" ", " ", "(", ")", "/", ", ", "®"};
+  static const char letters[]           = "abcdeilmnoprstuvx.{}AZ";
+  size_t len = 0;
+  str[0]     = '\0';
+  for (int words = rand() % 8; words > 0; words--) {
+    char word[64];
+    int kind = rand() % 3;
+    if (kind == 0) {
+      snprintf(word, sizeof(word), "%s", rules[rand() % rule_count][0]);
+      for (char* c = word; ignore_case && *c; c++)
+        if (rand() % 2) *c = toupper(*c);
+    } else if (kind == 1)
+      snprintf(word, sizeof(word), "%s", rules[rand() % rule_count][1]);
+    else {
+      int word_len = rand() % 6;
+      for (int i = 0; i < word_len; i++) word[i] = letters[rand() % (sizeof(letters) - 1)];
+      word[word_len] = '\0';
+    }
+    const char* separator = glued ? "" : separators[rand() % (sizeof(separators) / sizeof(separators[0]))];
+    if (len + strlen(word) + strlen(separator) >= size) break;
+    len += sprintf(str + len, "%s%s", word, separator);
+  }
+  return len;
+}
+
+// the rule of uwufy the slow way: at every character, the first rule matching there is replaced
+static void leftmost_uwufy(const char* const rules[][2], int rule_count, bool ignore_case, const char* str, char* out) {
+  while (*str) {
+    int found = -1;
+    for (int i = 0; i < rule_count && found < 0; i++)
+      if ((ignore_case ? strncasecmp : strncmp)(str, rules[i][0], strlen(rules[i][0])) == 0) found = i;
+    if (found < 0)
+      *out++ = *str++;
+    else {
+      out = stpcpy(out, rules[found][1]);
+      str += strlen(rules[found][0]);
+    }
+  }
+  *out = '\0';
+}
+
+// returns the number of strings uwufied wrongly: differently from the old loops, or from leftmost_uwufy when words are glued
+static int fuzz(const char* name, const char* const rules[][2], int rule_count, bool ignore_case, bool glued, int runs) {
+  static struct uwufier uwufier;
+  if (!build_uwufier(&uwufier, rules, rule_count, ignore_case)) {
+    printf("%-10s does not fit in the uwufier\n", name);
+    return 1;
+  }
+  int wrong = 0, overlaps = 0; // overlaps: glued strings where the old loops differ, as expected
+  for (int i = 0; i < runs; i++) {
+    char str[200], old[1024], new[1024], expected[1024];
+    random_string(rules, rule_count, ignore_case, glued, str, sizeof(str));
+    strcpy(old, str);
+    old_uwufy(rules, rule_count, ignore_case, old);
+    uwufy(&uwufier, str, new, sizeof(new));
+    if (glued) {
+      leftmost_uwufy(rules, rule_count, ignore_case, str, expected);
+      overlaps += strcmp(old, new) != 0;
+    } else
+      strcpy(expected, old);
+    if (strcmp(expected, new) != 0 && wrong++ < 5) printf("%s: \"%s\"\n  expected \"%s\"\n  new      \"%s\"\n", name, str, expected, new);
+  }
+  printf("%-10s %-9s %d strings, %d wrong", name, glued ? "glued" : "separated", runs, wrong);
+  if (glued) printf(", %d overlapping patterns replaced differently than the old loops", overlaps);
+  printf("\n");
+  return wrong;
+}
+
+// glued words whose patterns overlap, uwufied differently on purpose: the old loops replaced the pattern that comes first
+// in the table, then matched the others again in what was left, uwufy replaces the one that starts first
+static const struct {
+  bool hardware; // in hw_rules, or in pkgman_rules
+  const char *str, *old, *new;
+} overlapping[] = {
+    {true, "electronicpu", "ElectrOwOnicPUwU", "ElectrOwOnicpu"}, // the c of "cpu" ended "electronic"
+    {true, "auradeon", "Uwuradenyan", "Uwuradeon"},
+    {false, "snapacman", "snyapacnyan", "snyapacman"},
+    {false, "snaport", "snyapowt", "snyaport"},
+};
+
+// returns the number of overlapping strings not uwufied as recorded
+static int check_overlapping() {
+  static struct uwufier hw_uwufier, pkgman_uwufier;
+  build_uwufier(&hw_uwufier, hw_rules, sizeof(hw_rules) / sizeof(hw_rules[0]), true);
+  build_uwufier(&pkgman_uwufier, pkgman_rules, sizeof(pkgman_rules) / sizeof(pkgman_rules[0]), true);
+  int wrong = 0;
+  for (size_t i = 0; i < sizeof(overlapping) / sizeof(overlapping[0]); i++) {
+    char old[1024], new[1024];
+    strcpy(old, overlapping[i].str);
+    if (overlapping[i].hardware) {
+      old_uwufy(hw_rules, sizeof(hw_rules) / sizeof(hw_rules[0]), true, old);
+      uwufy(&hw_uwufier, overlapping[i].str, new, sizeof(new));
+    } else {
+      old_uwufy(pkgman_rules, sizeof(pkgman_rules) / sizeof(pkgman_rules[0]), true, old);
+      uwufy(&pkgman_uwufier, overlapping[i].str, new, sizeof(new));
+    }
+    if (strcmp(old, overlapping[i].old) != 0 || strcmp(new, overlapping[i].new) != 0) {
+      printf("overlapping: \"%s\"\n  old \"%s\", recorded \"%s\"\n  new \"%s\", recorded \"%s\"\n", overlapping[i].str, old,
+             overlapping[i].old, new, overlapping[i].new);
+      wrong++;
+    }
+  }
+  printf("%-10s %-9s %zu strings, %d wrong\n", "overlaps", "recorded", sizeof(overlapping) / sizeof(overlapping[0]), wrong);
+  return wrong;
+}
+
+int main(int argc, char** argv) {
+  int runs = argc > 1 && atoi(argv[1]) > 0 ? atoi(argv[1]) : 100000;
+  srand(1); // the same strings every time
+  int wrong = check_overlapping();
+  for (int glued = 0; glued < 2; glued++) {
+    wrong += fuzz("hardware", hw_rules, sizeof(hw_rules) / sizeof(hw_rules[0]), true, glued, runs);
+    wrong += fuzz("pkgman", pkgman_rules, sizeof(pkgman_rules) / sizeof(pkgman_rules[0]), true, glued, runs);
+    wrong += fuzz("colors", color_rules, sizeof(color_rules) / sizeof(color_rules[0]), false, glued, runs);
+  }
+  return wrong != 0;
+}
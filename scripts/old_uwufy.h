@@ -0,0 +1,41 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// the replace loops uwufy replaced, for fuzz_uwufy and bench_uwufy
+
+#ifndef _OLD_UWUFY_H_
+#define _OLD_UWUFY_H_
+
+// replace and replace_ignorecase of uwufetch.c before uwufy
+static void old_replace(char* original, const char* search, const char* replacer, bool ignore_case) {
+  char* ch;
+  char buffer[1024];
+  int offset = 0;
+  while ((ch = ignore_case ? strcasestr(original + offset, search) : strstr(original + offset, search))) {
+    strncpy(buffer, original, ch - original);
+    buffer[ch - original] = 0;
+    sprintf(buffer + (ch - original), "%s%s", replacer, ch + strlen(search));
+    original[0] = 0;
+    strcpy(original, buffer);
+    offset = ch - original + strlen(replacer);
+  }
+}
+
+// the rules applied one after the other to str, as uwu_hw, uwu_pkgman and print_ascii did
+static void old_uwufy(const char* const rules[][2], int rule_count, bool ignore_case, char* str) {
+  for (int i = 0; i < rule_count; i++) old_replace(str, rules[i][0], rules[i][1], ignore_case);
+}
+
+#endif // _OLD_UWUFY_H_
@@ -17,11 +17,34 @@
   #define UWUFETCH_VERSION "unkown" // needs to be changed by the build script
 #endif
 
-#define _GNU_SOURCE // for strcasestr
+#define _GNU_SOURCE
 
+#include "distros.h"
 #include "fetch.h"
+#include "uwufetchd.h"
+#include <ctype.h>
 #include <getopt.h>
 #include <stdbool.h>
+#include <stdint.h>
+#ifndef _WIN32
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <sched.h>
+  #include <sys/file.h>
+  #include <sys/mman.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/un.h>
+  #include <sys/wait.h>
+  #include <time.h>
+#endif
+
+#define CACHE_REFRESH_INTERVAL 30 // seconds before a stale cache is refreshed again
+#define DAEMON_TIMEOUT 100        // milliseconds uwufetchd has to send its snapshot
+#define SNAPSHOT_DIR "/run/uwufetch"
+#define SNAPSHOT_FILE SNAPSHOT_DIR "/snapshot"
+#define SNAPSHOT_RETRIES 64    // copies attempted while the snapshot is being published
+#define SNAPSHOT_MAX_AGE 86400 // seconds after which a snapshot is not trusted anymore
 
 // COLORS
 #define NORMAL "\x1b[0m"
@@ -37,6 +60,18 @@
 #define WHITE "\x1b[37m"
 #define PINK "\x1b[38;5;201m"
 #define LPINK "\x1b[38;5;213m"
+#define BACKGROUND_GREEN "\x1b[0;42m"
+#define BACKGROUND_RED "\x1b[0;41m"
+#define BACKGROUND_WHITE "\x1b[0;47m"
+#define BLOCK BLOCK_CHAR
+#define BLOCK_VERTICAL BLOCK_CHAR
+
+// {PLACEHOLDER}s of the ascii logos, each one is replaced by the macro with its name
+#define LOGO_PLACEHOLDERS                                                                                                     \
+  PLACEHOLDER(NORMAL) PLACEHOLDER(BOLD) PLACEHOLDER(BLACK) PLACEHOLDER(RED) PLACEHOLDER(GREEN) PLACEHOLDER(SPRING_GREEN)      \
+  PLACEHOLDER(YELLOW) PLACEHOLDER(BLUE) PLACEHOLDER(MAGENTA) PLACEHOLDER(CYAN) PLACEHOLDER(WHITE) PLACEHOLDER(PINK)           \
+  PLACEHOLDER(LPINK) PLACEHOLDER(BLOCK) PLACEHOLDER(BLOCK_VERTICAL) PLACEHOLDER(BACKGROUND_GREEN) PLACEHOLDER(BACKGROUND_RED) \
+  PLACEHOLDER(BACKGROUND_WHITE)
 
 #ifdef _WIN32
   #define BLOCK_CHAR "\xdb"     // block char for colors
@@ -46,6 +81,56 @@ char* MOVE_CURSOR = "\033[21C"; // moves the cursor after printing the image or
 char* MOVE_CURSOR = "\033[18C";
 #endif // _WIN32
 
+struct distro {
+  const char *id, *uwu_name, *logo;
+  enum distro_group group;
+  const char* color;
+};
+
+static const struct distro distros[] = {
+#define DISTRO(id, uwu_name, logo, group, color) {id, uwu_name, logo, group, color},
+    DISTROS
+#undef DISTRO
+};
+
+_Static_assert(sizeof(distros) / sizeof(distros[0]) * 2 <= DISTRO_SLOTS, "DISTRO_SLOTS is too small");
+
+// open addressing table of distros by id, index in distros + 1 (0 if empty)
+static const unsigned char distro_slots[DISTRO_SLOTS] = {
+#include "distro_slots.h"
+};
+
+static uint64_t hash_string(uint64_t hash, const char* string) { // fnv-1a
+  for (; string && *string; string++) hash = (hash ^ (unsigned char)*string) * 0x100000001b3ULL;
+  return hash;
+}
+
+// finds the distribution with the given os-release id, NULL if it is not supported
+static const struct distro* find_distro(const char* id) {
+  for (unsigned slot = distro_slot(id); distro_slots[slot]; slot = (slot + 1) & (DISTRO_SLOTS - 1))
+    if (strcmp(distros[distro_slots[slot] - 1].id, id) == 0) return &distros[distro_slots[slot] - 1];
+  return NULL;
+}
+
+// name of the logo files of the given os, the os itself if it is not supported (it can still have a logo)
+static const char* distro_logo(const char* os_name) {
+  const struct distro* distro = find_distro(os_name);
+  return distro ? distro->logo : os_name;
+}
+
+// res/ascii, converted by scripts/embed_logos.sh at build time
+struct embedded_logo {
+  const char *name, *text; // text is printed as it is, with the placeholders expanded by the compiler
+  int width, height;       // columns of the widest line, lines of text
+  size_t len;
+};
+
+static const struct embedded_logo embedded_logos[] = {
+#define LOGO(name, width, height, text) {name, "\n" text NORMAL, width, height, sizeof("\n" text NORMAL) - 1},
+#include "logos.h"
+#undef LOGO
+};
+
 #ifdef __DEBUG__
 static bool* verbose_enabled = NULL;
 #endif
@@ -55,136 +140,140 @@ struct configuration {
   struct flags show; // all true by default
   bool show_image,   // false by default
       show_colors;   // true by default
-  bool show_gpu[256];
+  bool show_gpu[MAX_GPUS];
   bool show_gpus; // global gpu toggle
+  int deadline;   // milliseconds commands can run before their fields are taken from the cache, 0 by default (no limit)
+  char cache_dir[512]; // replaces the host-keyed cache directory, empty by default
 };
 
 // user's config stored on the disk
 struct user_config {
   char *config_directory, // configuration directory name
       *cache_content;     // cache file content
-  int read_enabled, write_enabled;
+  int read_enabled, write_enabled,
+      refresh_enabled, // refresh the cache in the background after reading it
+      export_enabled,  // print the cache in its text format
+      publish_enabled; // publish the system-wide snapshot (as root) instead of printing
+};
+
+// keys of the config file, in the order handled by store_config
+static const char* const config_keys[] = {"distro", "image", "gpu", "gpus", "colors", "user", "os", "host",
+                                          "kernel", "cpu", "ram", "resolution", "shell", "pkgs", "uptime", "deadline", "cache_dir"};
+
+// state of the config file parsing, passed to store_config
+struct config_parser {
+  struct info* user_info;
+  struct configuration* config_flags;
 };
 
+// scan_fn storing a config value
+static void store_config(int key, const char* value, size_t len, void* arg) {
+  struct info* user_info             = ((struct config_parser*)arg)->user_info;
+  struct configuration* config_flags = ((struct config_parser*)arg)->config_flags;
+  bool* show_flags[]                 = {&config_flags->show.user, &config_flags->show.os, &config_flags->show.model,
+                                        &config_flags->show.kernel, &config_flags->show.cpu, &config_flags->show.ram,
+                                        &config_flags->show.resolution, &config_flags->show.shell, &config_flags->show.pkgs,
+                                        &config_flags->show.uptime};
+  char toggle[8]                     = ""; // true or false, anything after it (like a comment) is ignored
+  size_t toggle_len                  = strspn(value, "truefals");
+  if (toggle_len > len) toggle_len = len;
+  if (toggle_len < sizeof(toggle)) sprintf(toggle, "%.*s", (int)toggle_len, value);
+  switch (key) {
+  case 0: // distro
+    sscanf(value, "%63s", user_info->os_name);
+    break;
+  case 1: // image="path"
+    if (len < 2 || value[0] != '"' || !memchr(value + 1, '"', len - 1)) break;
+    snprintf(user_info->image_name, sizeof(user_info->image_name), "%.*s", (int)((char*)memchr(value + 1, '"', len - 1) - value - 1), value + 1);
+    if (user_info->image_name[0] == '~') {                                                          // replacing the ~ character with the home directory
+      memmove(&user_info->image_name[0], &user_info->image_name[1], strlen(user_info->image_name)); // remove the first char
+      char temp[128] = "/home/";
+      strcat(temp, user_info->user);
+      strcat(temp, user_info->image_name);
+      sprintf(user_info->image_name, "%s", temp);
+    }
+    config_flags->show_image = 1; // enable the image flag
+    break;
+  case 2: { // gpu=index hides a gpu
+    char* end;
+    long gpu_cfg_count = strtol(value, &end, 10);
+    if (end == value) break;
+    if (gpu_cfg_count > MAX_GPUS - 1) {
+      LOG_E("gpu config index is too high, setting it to %d", MAX_GPUS - 1);
+      gpu_cfg_count = MAX_GPUS - 1;
+    } else if (gpu_cfg_count < 0) {
+      LOG_E("gpu config index is too low, setting it to 0");
+      gpu_cfg_count = 0;
+    }
+    config_flags->show_gpu[gpu_cfg_count] = false;
+    LOG_V(config_flags->show_gpu[gpu_cfg_count]);
+    break;
+  }
+  case 3: // global gpu toggle
+    if (!toggle_len) break;
+    config_flags->show_gpus = strcmp(toggle, "false") != 0;
+    config_flags->show.gpu  = config_flags->show_gpus; // enable getting gpu info
+    LOG_V(config_flags->show_gpus);
+    break;
+  case 4:
+    if (toggle_len) config_flags->show_colors = strcmp(toggle, "false");
+    LOG_V(config_flags->show_colors);
+    break;
+  case 5: // the user is shown only if explicitly enabled
+    if (toggle_len) config_flags->show.user = !strcmp(toggle, "true");
+    LOG_V(config_flags->show.user);
+    break;
+  case 15: // deadline in milliseconds
+    config_flags->deadline = atoi(value) > 0 ? atoi(value) : 0;
+    LOG_V(config_flags->deadline);
+    break;
+  case 16: // cache_dir=path
+    sscanf(value, "%511s", config_flags->cache_dir);
+    LOG_V(config_flags->cache_dir);
+    break;
+  default:
+    if (toggle_len) *show_flags[key - 5] = strcmp(toggle, "false");
+    LOG_V(*show_flags[key - 5]);
+  }
+}
+
 // reads the config file
 struct configuration parse_config(struct info* user_info, struct user_config* user_config_file) {
   LOG_I("parsing config");
-  char buffer[256]; // buffer for the current line
+  char buffer[4096]; // the whole config file
   // enabling all flags by default
   struct configuration config_flags;
   memset(&config_flags, true, sizeof(config_flags));
 
   config_flags.show_image = false;
+  config_flags.deadline   = 0;
+  config_flags.cache_dir[0] = '\0';
 
-  FILE* config = NULL; // config file pointer
+  struct config_parser parser = {user_info, &config_flags};
+  int found                   = -1;
 
   if (user_config_file->config_directory == NULL) { // if config directory is not set, try to open the default
     if (getenv("HOME") != NULL) {
       char homedir[512];
       sprintf(homedir, "%s/.config/uwufetch/config", getenv("HOME"));
       LOG_V(homedir);
-      config = fopen(homedir, "r");
-      if (!config) {
+      found = scan_file(homedir, buffer, sizeof(buffer), '=', config_keys, 17, store_config, &parser);
+      if (found < 0) {
         if (getenv("PREFIX") != NULL) {
           char prefixed_etc[512];
           sprintf(prefixed_etc, "%s/etc/uwufetch/config", getenv("PREFIX"));
           LOG_V(prefixed_etc);
-          config = fopen(prefixed_etc, "r");
+          found = scan_file(prefixed_etc, buffer, sizeof(buffer), '=', config_keys, 17, store_config, &parser);
         } else
-          config = fopen("/etc/uwufetch/config", "r");
+          found = scan_file("/etc/uwufetch/config", buffer, sizeof(buffer), '=', config_keys, 17, store_config, &parser);
       }
     }
   } else
-    config = fopen(user_config_file->config_directory, "r");
-  if (config == NULL) return config_flags; // if config file does not exist, return the defaults
-
-  int gpu_cfg_count = 0;
-
-  // reading the config file
-  while (fgets(buffer, sizeof(buffer), config)) {
-    sscanf(buffer, "distro=%s", user_info->os_name);
-    if (sscanf(buffer, "image=\"%[^\"]\"", user_info->image_name)) {
-      if (user_info->image_name[0] == '~') {                                                          // replacing the ~ character with the home directory
-        memmove(&user_info->image_name[0], &user_info->image_name[1], strlen(user_info->image_name)); // remove the first char
-        char temp[128] = "/home/";
-        strcat(temp, user_info->user);
-        strcat(temp, user_info->image_name);
-        sprintf(user_info->image_name, "%s", temp);
-      }
-      config_flags.show_image = 1; // enable the image flag
-    }
+    found = scan_file(user_config_file->config_directory, buffer, sizeof(buffer), '=', config_keys, 17, store_config, &parser);
+  if (found < 0) return config_flags; // if config file does not exist, return the defaults
 
-    // reading other values
-    if (sscanf(buffer, "user=%[truefalse]", buffer)) {
-      config_flags.show.user = !strcmp(buffer, "true");
-      LOG_V(config_flags.show.user);
-    }
-    if (sscanf(buffer, "os=%[truefalse]", buffer)) {
-      config_flags.show.os = strcmp(buffer, "false");
-      LOG_V(config_flags.show.os);
-    }
-    if (sscanf(buffer, "host=%[truefalse]", buffer)) {
-      config_flags.show.model = strcmp(buffer, "false");
-      LOG_V(config_flags.show.model);
-    }
-    if (sscanf(buffer, "kernel=%[truefalse]", buffer)) {
-      config_flags.show.kernel = strcmp(buffer, "false");
-      LOG_V(config_flags.show.kernel);
-    }
-    if (sscanf(buffer, "cpu=%[truefalse]", buffer)) {
-      config_flags.show.cpu = strcmp(buffer, "false");
-      LOG_V(config_flags.show.cpu);
-    }
-    if (sscanf(buffer, "gpu=%d", &gpu_cfg_count)) {
-      if (gpu_cfg_count > 255) {
-        LOG_E("gpu config index is too high, setting it to 255");
-        gpu_cfg_count = 255;
-      } else if (gpu_cfg_count < 0) {
-        LOG_E("gpu config index is too low, setting it to 0");
-        gpu_cfg_count = 0;
-      }
-      config_flags.show_gpu[gpu_cfg_count] = false;
-      LOG_V(config_flags.show_gpu[gpu_cfg_count]);
-    }
-    if (sscanf(buffer, "gpus=%[truefalse]", buffer)) { // global gpu toggle
-      if (strcmp(buffer, "false") == 0) {
-        config_flags.show_gpus = false;
-        config_flags.show.gpu  = false; // enable getting gpu info
-      } else {
-        config_flags.show_gpus = true;
-        config_flags.show.gpu  = true;
-      }
-      LOG_V(config_flags.show_gpus);
-      LOG_V(config_flags.show.gpu);
-    }
-    if (sscanf(buffer, "ram=%[truefalse]", buffer)) {
-      config_flags.show.ram = strcmp(buffer, "false");
-      LOG_V(config_flags.show.ram);
-    }
-    if (sscanf(buffer, "resolution=%[truefalse]", buffer)) {
-      config_flags.show.resolution = strcmp(buffer, "false");
-      LOG_V(config_flags.show.resolution);
-    }
-    if (sscanf(buffer, "shell=%[truefalse]", buffer)) {
-      config_flags.show.shell = strcmp(buffer, "false");
-      LOG_V(config_flags.show.shell);
-    }
-    if (sscanf(buffer, "pkgs=%[truefalse]", buffer)) {
-      config_flags.show.pkgs = strcmp(buffer, "false");
-      LOG_V(config_flags.show.pkgs);
-    }
-    if (sscanf(buffer, "uptime=%[truefalse]", buffer)) {
-      config_flags.show.uptime = strcmp(buffer, "false");
-      LOG_V(config_flags.show.uptime);
-    }
-    if (sscanf(buffer, "colors=%[truefalse]", buffer)) {
-      config_flags.show_colors = strcmp(buffer, "false");
-      LOG_V(config_flags.show_colors);
-    }
-  }
   LOG_V(user_info->os_name);
   LOG_V(user_info->image_name);
-  fclose(config);
   return config_flags;
 }
 
@@ -197,7 +286,7 @@ int print_image(struct info* user_info) {
     char* repl_str = strcmp(user_info->os_name, "android") == 0 ? "/data/data/com.termux/files/usr/lib/uwufetch/%s.png"
                      : strcmp(user_info->os_name, "macos") == 0 ? "/usr/local/lib/uwufetch/%s.png"
                                                                 : "/usr/lib/uwufetch/%s.png";
-    sprintf(user_info->image_name, repl_str, user_info->os_name); // image command for android
+    sprintf(user_info->image_name, repl_str, distro_logo(user_info->os_name)); // image command for android
     LOG_V(user_info->image_name);
   }
   sprintf(command, "viu -t -w 18 -h 9 %s 2> /dev/null", user_info->image_name); // creating the command to show the image
@@ -224,37 +313,116 @@ int print_image(struct info* user_info) {
   return 9;
 }
 
-// Replaces all terms in a string with another term.
-void replace(char* original, char* search, char* replacer) {
-  char* ch;
-  char buffer[1024];
-  int offset = 0;
-  while ((ch = strstr(original + offset, search))) {
-    strncpy(buffer, original, ch - original);
-    buffer[ch - original] = 0;
-    sprintf(buffer + (ch - original), "%s%s", replacer, ch + strlen(search));
-    original[0] = 0;
-    strcpy(original, buffer);
-    offset = ch - original + strlen(replacer);
+#define UWUFIER_STATES 256 // more than the characters of all the patterns of a table
+#define UWUFIER_CLASSES 48 // more than the different characters of all the patterns of a table
+_Static_assert(UWUFIER_STATES <= 256 && UWUFIER_CLASSES <= 256, "states and classes are stored in an unsigned char");
+
+// rewrites the patterns of a table of {pattern, replacement} in one pass
+// it is an aho-corasick automaton, with the characters not in any pattern sharing the class 0
+struct uwufier {
+  const char* const (*rules)[2];
+  int rule_count, state_count; // 0 until built
+  bool ignore_case;
+  unsigned char classes[256];                        // column of each byte in next
+  unsigned char next[UWUFIER_STATES][UWUFIER_CLASSES]; // state after each class, suffix links already followed
+  short match[UWUFIER_STATES], depth[UWUFIER_STATES];  // longest pattern ending in the state (-1 if none), characters read
+};
+
+// returns false if the patterns need more than UWUFIER_STATES or UWUFIER_CLASSES, the uwufier then replaces nothing
+static bool build_uwufier(struct uwufier* uwufier, const char* const rules[][2], int rule_count, bool ignore_case) {
+  int class_count = 1;
+  short fail[UWUFIER_STATES] = {0}, queue[UWUFIER_STATES];
+  memset(uwufier, 0, sizeof(*uwufier));
+  uwufier->rules       = rules;
+  uwufier->rule_count  = rule_count;
+  uwufier->ignore_case = ignore_case;
+  uwufier->state_count = 1;
+  uwufier->match[0]    = -1;
+  uwufier->depth[0]    = 0;
+  // the trie of the patterns, 0 is also the "no transition yet" value as no edge leads back to the root
+  for (int i = 0; i < uwufier->rule_count; i++) {
+    int state = 0;
+    for (const unsigned char* c = (const unsigned char*)uwufier->rules[i][0]; *c; c++) {
+      unsigned char byte = uwufier->ignore_case ? tolower(*c) : *c;
+      if (!uwufier->classes[byte]) {
+        if (class_count == UWUFIER_CLASSES) {
+          LOG_E("the patterns have more than %d different characters, raise UWUFIER_CLASSES", UWUFIER_CLASSES - 1);
+          build_uwufier(uwufier, rules, 0, ignore_case); // no patterns, not half of them
+          return false;
+        }
+        uwufier->classes[byte] = class_count++;
+        if (uwufier->ignore_case) uwufier->classes[toupper(byte)] = uwufier->classes[byte];
+      }
+      unsigned char* next = &uwufier->next[state][uwufier->classes[byte]];
+      if (!*next) {
+        if (uwufier->state_count == UWUFIER_STATES) {
+          LOG_E("the patterns have more than %d characters, raise UWUFIER_STATES", UWUFIER_STATES - 1);
+          build_uwufier(uwufier, rules, 0, ignore_case);
+          return false;
+        }
+        uwufier->match[uwufier->state_count] = -1;
+        uwufier->depth[uwufier->state_count] = uwufier->depth[state] + 1;
+        *next                                = uwufier->state_count++;
+      }
+      state = *next;
+    }
+    if (uwufier->match[state] < 0) uwufier->match[state] = i; // the first rule wins over a duplicate
+  }
+  // suffix links in breadth first order, turning the trie into a full transition table
+  int head = 0, tail = 0;
+  for (int c = 0; c < UWUFIER_CLASSES; c++)
+    if (uwufier->next[0][c]) queue[tail++] = uwufier->next[0][c];
+  while (head < tail) {
+    int state = queue[head++];
+    if (uwufier->match[state] < 0) uwufier->match[state] = uwufier->match[fail[state]];
+    for (int c = 0; c < UWUFIER_CLASSES; c++) {
+      unsigned char* next = &uwufier->next[state][c];
+      if (*next) {
+        fail[*next]    = uwufier->next[fail[state]][c];
+        queue[tail++] = *next;
+      } else
+        *next = uwufier->next[fail[state]][c];
+    }
   }
+  return true;
 }
 
-// Replaces all terms in a string with another term, case insensitive
-void replace_ignorecase(char* original, char* search, char* replacer) {
-  char* ch;
-  char buffer[1024];
-  int offset = 0;
-#ifdef _WIN32
-  #define strcasestr(o, s) strstr(o, s)
-#endif
-  while ((ch = strcasestr(original + offset, search))) {
-    strncpy(buffer, original, ch - original);
-    buffer[ch - original] = 0;
-    sprintf(buffer + (ch - original), "%s%s", replacer, ch + strlen(search));
-    original[0] = 0;
-    strcpy(original, buffer);
-    offset = ch - original + strlen(replacer);
+// appends len bytes of str to out, as long as they fit
+static void append_bytes(char* out, size_t* used, size_t size, const char* str, size_t len) {
+  if (len > size - 1 - *used) len = size - 1 - *used;
+  memcpy(out + *used, str, len);
+  *used += len;
+}
+
+// writes str with every leftmost match replaced to out (the first rule wins when more start at the same character), returns its length
+size_t uwufy(const struct uwufier* uwufier, const char* str, char* out, size_t size) {
+  size_t len = strlen(str), used = 0, copied = 0, i = 0, match_start = 0, match_end = 0;
+  int state = 0, match = -1;
+  while (i < len || match >= 0) {
+    if (i < len) {
+      state = uwufier->next[state][uwufier->classes[(unsigned char)str[i++]]];
+      int found = uwufier->match[state];
+      if (found >= 0) {
+        size_t start = i - strlen(uwufier->rules[found][0]);
+        if (match < 0 || start < match_start || (start == match_start && found < match)) {
+          match       = found;
+          match_start = start;
+          match_end   = i;
+        }
+      }
+    }
+    // replaced once no other match can start before it
+    if (match >= 0 && (i == len || i - uwufier->depth[state] > match_start)) {
+      append_bytes(out, &used, size, str + copied, match_start - copied);
+      append_bytes(out, &used, size, uwufier->rules[match][1], strlen(uwufier->rules[match][1]));
+      copied = i = match_end;
+      state      = 0;
+      match      = -1;
+    }
   }
+  append_bytes(out, &used, size, str + copied, len - copied);
+  out[used] = '\0';
+  return used;
 }
 
 #ifdef _WIN32
@@ -275,175 +443,95 @@ char* strsep(char** stringp, const char* delim) {
 
 // uwufies distro name
 void uwu_name(struct info* user_info) {
-#define STRING_TO_UWU(original, uwufied) \
-  if (strcmp(user_info->os_name, original) == 0) sprintf(user_info->os_name, "%s", uwufied)
-  // linux
-  STRING_TO_UWU("alpine", "Nyalpine");
-  else STRING_TO_UWU("amogos", "AmogOwOS");
-  else STRING_TO_UWU("android", "Nyandroid");
-  else STRING_TO_UWU("arch", "Nyarch Linuwu");
-  else STRING_TO_UWU("arcolinux", "ArcOwO Linuwu");
-  else STRING_TO_UWU("artix", "Nyartix Linuwu");
-  else STRING_TO_UWU("debian", "Debinyan");
-  else STRING_TO_UWU("devuan", "Devunyan");
-  else STRING_TO_UWU("deepin", "Dewepyn");
-  else STRING_TO_UWU("endeavouros", "endeavOwO");
-  else STRING_TO_UWU("EndeavourOS", "endeavOwO");
-  else STRING_TO_UWU("fedora", "Fedowa");
-  else STRING_TO_UWU("femboyos", "FemboyOWOS");
-  else STRING_TO_UWU("gentoo", "GentOwO");
-  else STRING_TO_UWU("gnu", "gnUwU");
-  else STRING_TO_UWU("guix", "gnUwU gUwUix");
-  else STRING_TO_UWU("linuxmint", "LinUWU Miwint");
-  else STRING_TO_UWU("manjaro", "Myanjawo");
-  else STRING_TO_UWU("manjaro-arm", "Myanjawo AWM");
-  else STRING_TO_UWU("neon", "KDE NeOwOn");
-  else STRING_TO_UWU("nixos", "nixOwOs");
-  else STRING_TO_UWU("opensuse-leap", "OwOpenSUSE Leap");
-  else STRING_TO_UWU("opensuse-tumbleweed", "OwOpenSUSE Tumbleweed");
-  else STRING_TO_UWU("pop", "PopOwOS");
-  else STRING_TO_UWU("raspbian", "RaspNyan");
-  else STRING_TO_UWU("rocky", "Wocky Linuwu");
-  else STRING_TO_UWU("slackware", "Swackwawe");
-  else STRING_TO_UWU("solus", "sOwOlus");
-  else STRING_TO_UWU("ubuntu", "Uwuntu");
-  else STRING_TO_UWU("void", "OwOid");
-  else STRING_TO_UWU("xerolinux", "xuwulinux");
-
-  // BSD
-  else STRING_TO_UWU("freebsd", "FweeBSD");
-  else STRING_TO_UWU("openbsd", "OwOpenBSD");
-
-  // Apple family
-  else STRING_TO_UWU("macos", "macOwOS");
-  else STRING_TO_UWU("ios", "iOwOS");
-
-  // Windows
-  else STRING_TO_UWU("windows", "WinyandOwOws");
-
-  else sprintf(user_info->os_name, "%s", "unknown");
-#undef STRING_TO_UWU
+  const struct distro* distro = find_distro(user_info->os_name);
+  sprintf(user_info->os_name, "%s", distro ? distro->uwu_name : "unknown");
 }
 
 // uwufies kernel name
 void uwu_kernel(char* kernel) {
-#define KERNEL_TO_UWU(str, original, uwufied) \
-  if (strcmp(str, original) == 0) sprintf(str, "%s", uwufied)
-
   LOG_I("uwufing kernel");
 
   char* temp_kernel = kernel;
   char* token;
-  char splitted[16][128] = {};
-
-  int count = 0;
-  while ((token = strsep(&temp_kernel, " "))) { // split kernel name
-    strcpy(splitted[count], token);
-    count++;
-  }
-  strcpy(kernel, "");
-  for (int i = 0; i < 16; i++) {
-    // replace kernel name with uwufied version
-    KERNEL_TO_UWU(splitted[i], "Linux", "Linuwu");
-    else KERNEL_TO_UWU(splitted[i], "linux", "linuwu");
-    else KERNEL_TO_UWU(splitted[i], "alpine", "Nyalpine");
-    else KERNEL_TO_UWU(splitted[i], "amogos", "AmogOwOS");
-    else KERNEL_TO_UWU(splitted[i], "android", "Nyandroid");
-    else KERNEL_TO_UWU(splitted[i], "arch", "Nyarch Linuwu");
-    else KERNEL_TO_UWU(splitted[i], "artix", "Nyartix Linuwu");
-    else KERNEL_TO_UWU(splitted[i], "debian", "Debinyan");
-    else KERNEL_TO_UWU(splitted[i], "deepin", "Dewepyn");
-    else KERNEL_TO_UWU(splitted[i], "endeavouros", "endeavOwO");
-    else KERNEL_TO_UWU(splitted[i], "EndeavourOS", "endeavOwO");
-    else KERNEL_TO_UWU(splitted[i], "fedora", "Fedowa");
-    else KERNEL_TO_UWU(splitted[i], "femboyos", "FemboyOWOS");
-    else KERNEL_TO_UWU(splitted[i], "gentoo", "GentOwO");
-    else KERNEL_TO_UWU(splitted[i], "gnu", "gnUwU");
-    else KERNEL_TO_UWU(splitted[i], "guix", "gnUwU gUwUix");
-    else KERNEL_TO_UWU(splitted[i], "linuxmint", "LinUWU Miwint");
-    else KERNEL_TO_UWU(splitted[i], "manjaro", "Myanjawo");
-    else KERNEL_TO_UWU(splitted[i], "manjaro-arm", "Myanjawo AWM");
-    else KERNEL_TO_UWU(splitted[i], "neon", "KDE NeOwOn");
-    else KERNEL_TO_UWU(splitted[i], "nixos", "nixOwOs");
-    else KERNEL_TO_UWU(splitted[i], "opensuse-leap", "OwOpenSUSE Leap");
-    else KERNEL_TO_UWU(splitted[i], "opensuse-tumbleweed", "OwOpenSUSE Tumbleweed");
-    else KERNEL_TO_UWU(splitted[i], "pop", "PopOwOS");
-    else KERNEL_TO_UWU(splitted[i], "raspbian", "RaspNyan");
-    else KERNEL_TO_UWU(splitted[i], "rocky", "Wocky Linuwu");
-    else KERNEL_TO_UWU(splitted[i], "slackware", "Swackwawe");
-    else KERNEL_TO_UWU(splitted[i], "solus", "sOwOlus");
-    else KERNEL_TO_UWU(splitted[i], "ubuntu", "Uwuntu");
-    else KERNEL_TO_UWU(splitted[i], "void", "OwOid");
-    else KERNEL_TO_UWU(splitted[i], "xerolinux", "xuwulinux");
-
-    // BSD
-    else KERNEL_TO_UWU(splitted[i], "freebsd", "FweeBSD");
-    else KERNEL_TO_UWU(splitted[i], "openbsd", "OwOpenBSD");
-
-    // Apple family
-    else KERNEL_TO_UWU(splitted[i], "macos", "macOwOS");
-    else KERNEL_TO_UWU(splitted[i], "ios", "iOwOS");
-
-    // Windows
-    else KERNEL_TO_UWU(splitted[i], "windows", "WinyandOwOws");
-
-    if (i != 0) strcat(kernel, " ");
-    strcat(kernel, splitted[i]);
-  }
-#undef KERNEL_TO_UWU
+  char uwufied[256]; // same size as the kernel of struct info
+  size_t len = 0;
+
+  for (int i = 0; len < sizeof(uwufied) && (token = strsep(&temp_kernel, " ")); i++) { // uwufy the kernel name word by word
+    const struct distro* distro = find_distro(token);
+    const char* word            = distro ? distro->uwu_name : token;
+    if (strcmp(token, "Linux") == 0)
+      word = "Linuwu";
+    else if (strcmp(token, "linux") == 0)
+      word = "linuwu";
+    len += snprintf(uwufied + len, sizeof(uwufied) - len, "%s%s", i ? " " : "", word);
+  }
+  strcpy(kernel, uwufied);
   LOG_V(kernel);
 }
 
+// patterns of the hardware names and their uwufied version, the first one wins when two start at the same character
+static const char* const hw_rules[][2] = {
+    {"lenovo", "LenOwO"},
+    {"cpu", "CPUwU"},
+    {"core", "Cowe"},
+    {"gpu", "GPUwU"},
+    {"graphics", "Gwaphics"},
+    {"corporation", "COwOpowation"},
+    {"nvidia", "NyaVIDIA"},
+    {"mobile", "Mwobile"},
+    {"intel", "Inteww"},
+    {"celeron", "Celewon"},
+    {"radeon", "Radenyan"},
+    {"geforce", "GeFOwOce"},
+    {"raspberry", "Nyasberry"},
+    {"broadcom", "Bwoadcom"},
+    {"motorola", "MotOwOwa"},
+    {"proliant", "ProLinyant"},
+    {"poweredge", "POwOwEdge"},
+    {"apple", "Nyapple"},
+    {"electronic", "ElectrOwOnic"},
+    {"processor", "Pwocessow"},
+    {"microsoft", "MicOwOsoft"},
+    {"ryzen", "Wyzen"},
+    {"advanced", "Adwanced"},
+    {"micro", "Micwo"},
+    {"devices", "Dewices"},
+    {"inc.", "Nyanc."},
+    {"lucienne", "Lucienyan"},
+    {"tuxedo", "TUWUXEDO"},
+    {"aura", "Uwura"},
+};
+
 // uwufies hardware names
-void uwu_hw(char* hwname) {
+void uwu_hw(char* hwname, size_t size) {
   LOG_I("uwufing hardware")
-#define HW_TO_UWU(original, uwuified) replace_ignorecase(hwname, original, uwuified);
-  HW_TO_UWU("lenovo", "LenOwO")
-  HW_TO_UWU("cpu", "CPUwU");
-  HW_TO_UWU("core", "Cowe");
-  HW_TO_UWU("gpu", "GPUwU")
-  HW_TO_UWU("graphics", "Gwaphics")
-  HW_TO_UWU("corporation", "COwOpowation")
-  HW_TO_UWU("nvidia", "NyaVIDIA")
-  HW_TO_UWU("mobile", "Mwobile")
-  HW_TO_UWU("intel", "Inteww")
-  HW_TO_UWU("celeron", "Celewon")
-  HW_TO_UWU("radeon", "Radenyan")
-  HW_TO_UWU("geforce", "GeFOwOce")
-  HW_TO_UWU("raspberry", "Nyasberry")
-  HW_TO_UWU("broadcom", "Bwoadcom")
-  HW_TO_UWU("motorola", "MotOwOwa")
-  HW_TO_UWU("proliant", "ProLinyant")
-  HW_TO_UWU("poweredge", "POwOwEdge")
-  HW_TO_UWU("apple", "Nyapple")
-  HW_TO_UWU("electronic", "ElectrOwOnic")
-  HW_TO_UWU("processor", "Pwocessow")
-  HW_TO_UWU("microsoft", "MicOwOsoft")
-  HW_TO_UWU("ryzen", "Wyzen")
-  HW_TO_UWU("advanced", "Adwanced")
-  HW_TO_UWU("micro", "Micwo")
-  HW_TO_UWU("devices", "Dewices")
-  HW_TO_UWU("inc.", "Nyanc.")
-  HW_TO_UWU("lucienne", "Lucienyan")
-  HW_TO_UWU("tuxedo", "TUWUXEDO")
-  HW_TO_UWU("aura", "Uwura")
-#undef HW_TO_UWU
+  static struct uwufier hw_uwufier;
+  if (!hw_uwufier.state_count) build_uwufier(&hw_uwufier, hw_rules, sizeof(hw_rules) / sizeof(hw_rules[0]), true);
+  char original[size];
+  strcpy(original, hwname);
+  uwufy(&hw_uwufier, original, hwname, size);
 }
 
+// these package managers do not have edits yet:
+// apk, apt, guix, nix, pkg, xbps
+static const char* const pkgman_rules[][2] = {
+    {"brew-cask", "bwew-cawsk"},
+    {"brew-cellar", "bwew-cewwaw"},
+    {"emerge", "emewge"},
+    {"flatpak", "fwatpakkies"},
+    {"pacman", "pacnyan"},
+    {"port", "powt"},
+    {"snap", "snyap"},
+};
+
 // uwufies package manager names
-void uwu_pkgman(char* pkgman_name) {
+void uwu_pkgman(char* pkgman_name, size_t size) {
   LOG_I("uwufing package managers")
-#define PKGMAN_TO_UWU(original, uwuified) replace_ignorecase(pkgman_name, original, uwuified);
-  // these package managers do not have edits yet:
-  // apk, apt, guix, nix, pkg, xbps
-  PKGMAN_TO_UWU("brew-cask", "bwew-cawsk");
-  PKGMAN_TO_UWU("brew-cellar", "bwew-cewwaw");
-  PKGMAN_TO_UWU("emerge", "emewge");
-  PKGMAN_TO_UWU("flatpak", "fwatpakkies");
-  PKGMAN_TO_UWU("pacman", "pacnyan");
-  PKGMAN_TO_UWU("port", "powt");
-  PKGMAN_TO_UWU("snap", "snyap");
-#undef PKGMAN_TO_UWU
+  static struct uwufier pkgman_uwufier;
+  if (!pkgman_uwufier.state_count) build_uwufier(&pkgman_uwufier, pkgman_rules, sizeof(pkgman_rules) / sizeof(pkgman_rules[0]), true);
+  char original[size];
+  strcpy(original, pkgman_name);
+  uwufy(&pkgman_uwufier, original, pkgman_name, size);
 }
 
 // uwufies everything
@@ -452,12 +540,24 @@ void uwufy_all(struct info* user_info) {
   if (strcmp(user_info->os_name, "windows"))
     MOVE_CURSOR = "\033[21C"; // to print windows logo on not windows systems
   uwu_kernel(user_info->kernel);
-  for (int i = 0; user_info->gpu_model[i][0]; i++) uwu_hw(user_info->gpu_model[i]);
-  uwu_hw(user_info->cpu_model);
+  // names can grow, the arena is packed again with the uwufied ones instead of keeping both
+  char gpu_names[MAX_GPUS][256];
+  int gpu_count = user_info->gpu_count;
+  for (int i = 0; i < gpu_count; i++) {
+    snprintf(gpu_names[i], sizeof(gpu_names[i]), "%s", info_gpu(user_info, i));
+    uwu_hw(gpu_names[i], sizeof(gpu_names[i]));
+  }
+  info_clear_gpus(user_info);
+  for (int i = 0; i < gpu_count; i++)
+    if (!info_set_gpu(user_info, i, gpu_names[i], strlen(gpu_names[i]))) {
+      LOG_W("the uwufied names of %d gpus do not fit in the arena, showing %d", gpu_count, i);
+      break;
+    }
+  uwu_hw(user_info->cpu_model, sizeof(user_info->cpu_model));
   LOG_V(user_info->cpu_model);
-  uwu_hw(user_info->model);
+  uwu_hw(user_info->model, sizeof(user_info->model));
   LOG_V(user_info->model);
-  uwu_pkgman(user_info->pkgman_name);
+  uwu_pkgman(user_info->pkgman_name, sizeof(user_info->pkgman_name));
   LOG_V(user_info->pkgman_name);
 }
 
@@ -496,17 +596,25 @@ int print_info(struct configuration* config_flags, struct info* user_info) {
   if (config_flags->show.cpu)
     responsively_printf(print_buf, "%s%s%sCPUWU    %s%s", MOVE_CURSOR, NORMAL, BOLD, NORMAL, user_info->cpu_model);
 
-  for (int i = 0; i < 256; i++) {
+  for (int i = 0; i < user_info->gpu_count; i++) {
     if (config_flags->show_gpu[i])
-      if (user_info->gpu_model[i][0])
-        responsively_printf(print_buf, "%s%s%sGPUWU    %s%s", MOVE_CURSOR, NORMAL, BOLD, NORMAL, user_info->gpu_model[i]);
+      if (info_gpu(user_info, i)[0])
+        responsively_printf(print_buf, "%s%s%sGPUWU    %s%s", MOVE_CURSOR, NORMAL, BOLD, NORMAL, info_gpu(user_info, i));
   }
 
   if (config_flags->show.ram) // print ram
     responsively_printf(print_buf, "%s%s%sMEMOWY   %s%i MiB/%i MiB", MOVE_CURSOR, NORMAL, BOLD, NORMAL, (user_info->ram_used), user_info->ram_total);
-  if (config_flags->show.resolution) // print resolution
-    if (user_info->screen_width != 0 || user_info->screen_height != 0)
+  if (config_flags->show.resolution) { // print resolution, one line per monitor
+    for (int i = 0; i < user_info->monitor_count; i++) {
+      struct monitor* monitor = &user_info->monitors[i];
+      if (monitor->refresh_rate)
+        responsively_printf(print_buf, "%s%s%sWESOWUTION%s  %dx%d @ %dHz", MOVE_CURSOR, NORMAL, BOLD, NORMAL, monitor->width, monitor->height, monitor->refresh_rate)
+      else
+        responsively_printf(print_buf, "%s%s%sWESOWUTION%s  %dx%d", MOVE_CURSOR, NORMAL, BOLD, NORMAL, monitor->width, monitor->height);
+    }
+    if (user_info->monitor_count == 0 && (user_info->screen_width != 0 || user_info->screen_height != 0))
       responsively_printf(print_buf, "%s%s%sWESOWUTION%s  %dx%d", MOVE_CURSOR, NORMAL, BOLD, NORMAL, user_info->screen_width, user_info->screen_height);
+  }
   if (config_flags->show.shell) // print shell name
     responsively_printf(print_buf, "%s%s%sSHEWW    %s%s", MOVE_CURSOR, NORMAL, BOLD, NORMAL, user_info->shell);
   if (config_flags->show.pkgs) // print pkgs
@@ -535,18 +643,242 @@ int print_info(struct configuration* config_flags, struct info* user_info) {
   return line_count;
 }
 
-// writes cache to cache file
-void write_cache(struct info* user_info) {
+// fields of the cache, in the same order as the keys of its text format
+enum cache_field {
+  CACHE_USER,
+  CACHE_HOST,
+  CACHE_OS,
+  CACHE_MODEL,
+  CACHE_KERNEL,
+  CACHE_CPU,
+  CACHE_SHELL,
+  CACHE_PKGMAN,
+  CACHE_GPU,
+  CACHE_SCREEN_WIDTH,
+  CACHE_SCREEN_HEIGHT,
+  CACHE_PKGS,
+  CACHE_MONITOR,
+  CACHE_FIELDS
+};
+
+// keys of the cache text format, in the order handled by store_cache
+static const char* const cache_keys[CACHE_FIELDS] = {"user", "host", "version_name", "host_model", "kernel", "cpu", "shell",
+                                                     "pkgman_name", "gpu", "screen_width", "screen_height", "pkgs", "monitor"};
+
+// what a cached value depends on, it is collected again when the fingerprint of its source changes
+enum cache_source { SOURCE_NONE, SOURCE_BOOT, SOURCE_KERNEL, SOURCE_USER, SOURCE_SHELL, SOURCE_OS_RELEASE, SOURCE_COUNT };
+
+static const struct cache_field_info {
+  int ttl; // seconds a value stays valid, 0 if only its source can change it
+  enum cache_source source;
+} cache_fields[CACHE_FIELDS] = {
+    [CACHE_USER] = {0, SOURCE_USER},           [CACHE_HOST] = {0, SOURCE_USER},
+    [CACHE_OS] = {0, SOURCE_OS_RELEASE},       [CACHE_MODEL] = {0, SOURCE_BOOT},
+    [CACHE_KERNEL] = {0, SOURCE_KERNEL},       [CACHE_CPU] = {0, SOURCE_BOOT},
+    [CACHE_SHELL] = {0, SOURCE_SHELL},         [CACHE_PKGMAN] = {300, SOURCE_NONE},
+    [CACHE_GPU] = {86400, SOURCE_BOOT},        [CACHE_SCREEN_WIDTH] = {300, SOURCE_NONE},
+    [CACHE_SCREEN_HEIGHT] = {300, SOURCE_NONE}, [CACHE_PKGS] = {300, SOURCE_NONE},
+    [CACHE_MONITOR] = {300, SOURCE_NONE},
+};
+
+#define CACHE_MAGIC "UWUCACHE"
+#define CACHE_VERSION 2
+
+// binary cache, read with a single mmap: a header followed by the records
+struct cache_header {
+  char magic[8];
+  uint32_t version, record_count;
+  int64_t created;
+};
+
+// a cached value, followed by len bytes of text padded to 8 bytes
+struct cache_record {
+  uint16_t field, len;
+  uint32_t ttl;
+  uint64_t fingerprint;
+  int64_t collected;
+};
+
+static int64_t cache_collected[CACHE_FIELDS]; // when the values read from the cache were collected
+
+// the flag that collects a cache field
+static bool* cache_field_flag(struct flags* flags, int field) {
+  switch (field) {
+  case CACHE_USER:
+  case CACHE_HOST:
+    return &flags->user;
+  case CACHE_OS:
+    return &flags->os;
+  case CACHE_MODEL:
+    return &flags->model;
+  case CACHE_KERNEL:
+    return &flags->kernel;
+  case CACHE_CPU:
+    return &flags->cpu;
+  case CACHE_SHELL:
+    return &flags->shell;
+  case CACHE_GPU:
+    return &flags->gpu;
+  case CACHE_PKGMAN:
+  case CACHE_PKGS:
+    return &flags->pkgs;
+  default:
+    return &flags->resolution;
+  }
+}
+
+static void get_boot_id(char* boot_id, size_t len) {
+  boot_id[0] = '\0';
+#ifdef __linux__
+  FILE* boot_id_fp = fopen("/proc/sys/kernel/random/boot_id", "r");
+  if (boot_id_fp) {
+    if (fgets(boot_id, len, boot_id_fp)) boot_id[strcspn(boot_id, "\n")] = '\0';
+    fclose(boot_id_fp);
+  }
+#else
+  (void)len;
+#endif
+}
+
+// fingerprints of the current state of every cache source
+static void get_fingerprints(uint64_t fingerprints[SOURCE_COUNT]) {
+  char buffer[256];
+  uint64_t basis = 0xcbf29ce484222325ULL;
+  fingerprints[SOURCE_NONE] = 0;
+  get_boot_id(buffer, sizeof(buffer));
+  fingerprints[SOURCE_BOOT] = hash_string(basis, buffer);
+  fingerprints[SOURCE_KERNEL] = basis;
+#ifndef _WIN32
+  struct utsname sys_var;
+  if (uname(&sys_var) == 0) fingerprints[SOURCE_KERNEL] = hash_string(hash_string(basis, sys_var.release), sys_var.version);
+#endif
+  gethostname(buffer, sizeof(buffer));
+  fingerprints[SOURCE_USER]  = hash_string(hash_string(basis, getenv("USER")), buffer);
+  fingerprints[SOURCE_SHELL] = hash_string(basis, getenv("SHELL"));
+  struct stat os_release;
+  if (stat("/etc/os-release", &os_release) == 0) {
+    snprintf(buffer, sizeof(buffer), "%lld %lld %lld", (long long)os_release.st_ino, (long long)os_release.st_size, (long long)os_release.st_mtime);
+    fingerprints[SOURCE_OS_RELEASE] = hash_string(basis, buffer);
+  } else
+    fingerprints[SOURCE_OS_RELEASE] = basis;
+}
+
+// appends a record to the cache being written
+static void add_record(char* cache, size_t* used, size_t size, int field, const char* value, const uint64_t fingerprints[SOURCE_COUNT], int64_t collected) {
+  size_t len = strlen(value), padded = (sizeof(struct cache_record) + len + 7) & ~(size_t)7;
+  if (*used + padded > size || len > UINT16_MAX) return;
+  struct cache_record record = {field, len, cache_fields[field].ttl, fingerprints[cache_fields[field].source], collected};
+  memcpy(cache + *used, &record, sizeof(record));
+  memcpy(cache + *used + sizeof(record), value, len);
+  memset(cache + *used + sizeof(record) + len, 0, padded - sizeof(record) - len);
+  *used += padded;
+  ((struct cache_header*)cache)->record_count++;
+}
+
+// clears the cached values of the fields that are going to be collected again, some collectors append to them
+void clear_fields(struct info* user_info, struct flags* fields) {
+  if (fields->user) user_info->user[0] = user_info->host[0] = '\0';
+  if (fields->os) user_info->os_name[0] = '\0';
+  if (fields->model) user_info->model[0] = '\0';
+  if (fields->kernel) user_info->kernel[0] = '\0';
+  if (fields->cpu) user_info->cpu_model[0] = '\0';
+  if (fields->shell) user_info->shell[0] = '\0';
+  if (fields->gpu) info_clear_gpus(user_info);
+  if (fields->resolution) user_info->monitor_count = user_info->screen_width = user_info->screen_height = 0;
+  if (fields->pkgs) {
+    user_info->pkgs           = 0;
+    user_info->pkgman_name[0] = '\0';
+  }
+}
+
+// takes the lock of the processes collecting values for the cache, returns -1 if wait is false and another process holds it
+int lock_cache(bool wait) {
+#ifndef _WIN32
+  char lock_file[600];
+  if (!get_cache_path("uwufetch.lock", lock_file, sizeof(lock_file))) return -1;
+  int lock_fd = open(lock_file, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (lock_fd >= 0 && flock(lock_fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB) != 0) {
+    close(lock_fd);
+    return -1;
+  }
+  return lock_fd;
+#else
+  (void)wait;
+  return 0;
+#endif
+}
+
+void unlock_cache(int lock_fd) {
+#ifndef _WIN32
+  if (lock_fd >= 0) close(lock_fd);
+#else
+  (void)lock_fd;
+#endif
+}
+
+// writes cache to cache file, fields in fresh were just collected, the others keep the time they were collected at (NULL if all are new)
+void write_cache(struct info* user_info, struct flags* fresh) {
   LOG_I("writing cache");
-  char cache_file[512];
-  sprintf(cache_file, "%s/.cache/uwufetch.cache", getenv("HOME")); // default cache file location
+  char cache_file[600];
+  if (!get_cache_path("uwufetch.cache", cache_file, sizeof(cache_file))) return;
   LOG_V(cache_file);
-  FILE* cache_fp = fopen(cache_file, "w");
+  static char cache[sizeof(struct cache_header) + (sizeof(struct info) + 24 * (MAX_GPUS + MAX_MONITORS + 16)) * 2];
+  size_t used = sizeof(struct cache_header);
+  uint64_t fingerprints[SOURCE_COUNT];
+  int64_t now = time(NULL), collected[CACHE_FIELDS];
+  get_fingerprints(fingerprints);
+  struct cache_header* header = (struct cache_header*)cache;
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, CACHE_MAGIC, 8);
+  header->version = CACHE_VERSION;
+  header->created = now;
+  for (int i = 0; i < CACHE_FIELDS; i++) collected[i] = !fresh || *cache_field_flag(fresh, i) || !cache_collected[i] ? now : cache_collected[i];
+
+  char* strings[] = {user_info->user, user_info->host, user_info->os_name, user_info->model,
+                     user_info->kernel, user_info->cpu_model, user_info->shell, user_info->pkgman_name};
+  for (int i = CACHE_USER; i <= CACHE_PKGMAN; i++) add_record(cache, &used, sizeof(cache), i, strings[i], fingerprints, collected[i]);
+  char value[64];
+  int numbers[] = {user_info->screen_width, user_info->screen_height, user_info->pkgs};
+  for (int i = CACHE_SCREEN_WIDTH; i <= CACHE_PKGS; i++) {
+    sprintf(value, "%d", numbers[i - CACHE_SCREEN_WIDTH]);
+    add_record(cache, &used, sizeof(cache), i, value, fingerprints, collected[i]);
+  }
+  // lists always get a record, even when empty, so that they are not collected again because they are missing
+  if (!user_info->gpu_count) add_record(cache, &used, sizeof(cache), CACHE_GPU, "", fingerprints, collected[CACHE_GPU]);
+  for (int i = 0; i < user_info->gpu_count; i++) add_record(cache, &used, sizeof(cache), CACHE_GPU, info_gpu(user_info, i), fingerprints, collected[CACHE_GPU]);
+  if (!user_info->monitor_count) add_record(cache, &used, sizeof(cache), CACHE_MONITOR, "", fingerprints, collected[CACHE_MONITOR]);
+  for (int i = 0; i < user_info->monitor_count; i++) {
+    sprintf(value, "%dx%d@%d", user_info->monitors[i].width, user_info->monitors[i].height, user_info->monitors[i].refresh_rate);
+    add_record(cache, &used, sizeof(cache), CACHE_MONITOR, value, fingerprints, collected[CACHE_MONITOR]);
+  }
+
+#ifndef _WIN32
+  // written aside and renamed over the old cache, so that readers always map a whole generation
+  char tmp_file[620];
+  snprintf(tmp_file, sizeof(tmp_file), "%s.%d", cache_file, (int)getpid());
+  int cache_fd = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (cache_fd < 0) {
+    LOG_E("Failed to write to %s!", tmp_file);
+    return;
+  }
+  bool written = write(cache_fd, cache, used) == (ssize_t)used && fsync(cache_fd) == 0;
+  if (close(cache_fd) != 0 || !written || rename(tmp_file, cache_file) != 0) {
+    LOG_E("Failed to write to %s!", cache_file);
+    unlink(tmp_file);
+  }
+#else
+  FILE* cache_fp = fopen(cache_file, "wb");
   if (cache_fp == NULL) {
     LOG_E("Failed to write to %s!", cache_file);
     return;
   }
-  // writing all info to the cache file
+  fwrite(cache, 1, used, cache_fp);
+  fclose(cache_fp);
+#endif
+}
+
+// writes the cache in its text format, one key=value line per value
+void export_cache(FILE* cache_fp, struct info* user_info) {
   fprintf( // writing most of the values to config file
       cache_fp,
       "user=%s\nhost=%s\nversion_name=%s\nhost_model=%s\nkernel=%s\ncpu=%"
@@ -556,68 +888,348 @@ void write_cache(struct info* user_info) {
       user_info->cpu_model, user_info->screen_width, user_info->screen_height, user_info->shell,
       user_info->pkgs, user_info->pkgman_name);
 
-  for (int i = 0; user_info->gpu_model[i][0]; i++) // writing gpu names to file
-    fprintf(cache_fp, "gpu=%s\n", user_info->gpu_model[i]);
+  for (int i = 0; i < user_info->gpu_count; i++) // writing gpu names to file
+    fprintf(cache_fp, "gpu=%s\n", info_gpu(user_info, i));
+  for (int i = 0; i < user_info->monitor_count; i++) // writing monitors to file
+    fprintf(cache_fp, "monitor=%dx%d@%d\n", user_info->monitors[i].width, user_info->monitors[i].height, user_info->monitors[i].refresh_rate);
+}
 
-  fclose(cache_fp);
-  return;
+// scan_fn storing a cached value
+static void store_cache(int key, const char* value, size_t len, void* arg) {
+  struct info* user_info = arg;
+  char* strings[]        = {user_info->user, user_info->host, user_info->os_name, user_info->model,
+                            user_info->kernel, user_info->cpu_model, user_info->shell, user_info->pkgman_name};
+  size_t sizes[]         = {sizeof(user_info->user), sizeof(user_info->host), sizeof(user_info->os_name), sizeof(user_info->model),
+                            sizeof(user_info->kernel), sizeof(user_info->cpu_model), sizeof(user_info->shell), sizeof(user_info->pkgman_name)};
+  int* numbers[]         = {&user_info->screen_width, &user_info->screen_height, &user_info->pkgs};
+  char number[32];
+  if (key < CACHE_GPU)
+    snprintf(strings[key], sizes[key], "%.*s", (int)len, value);
+  else if (key == CACHE_GPU) { // gpu names, in order
+    if (len) info_set_gpu(user_info, user_info->gpu_count, value, len);
+  } else if (key < CACHE_MONITOR) {
+    snprintf(number, sizeof(number), "%.*s", (int)len, value); // values of the binary cache are not terminated
+    *numbers[key - CACHE_SCREEN_WIDTH] = atoi(number);
+  } else if (user_info->monitor_count < MAX_MONITORS) {
+    struct monitor* monitor = &user_info->monitors[user_info->monitor_count];
+    snprintf(number, sizeof(number), "%.*s", (int)len, value);
+    if (sscanf(number, "%dx%d@%d", &monitor->width, &monitor->height, &monitor->refresh_rate) == 3) user_info->monitor_count++;
+  }
+}
+
+// reads the records of a binary cache, marking in stale the fields that expired, changed source or are missing
+// after a reboot or a kernel upgrade only the fields depending on them are stale, returns false if it is not a binary cache
+static bool read_cache_records(const char* cache, size_t len, struct info* user_info, struct flags* stale) {
+  const struct cache_header* header = (const struct cache_header*)cache;
+  if (len < sizeof(*header) || memcmp(header->magic, CACHE_MAGIC, 8) != 0 || header->version != CACHE_VERSION) return false;
+  uint64_t fingerprints[SOURCE_COUNT];
+  bool found[CACHE_FIELDS] = {false};
+  int64_t now              = time(NULL);
+  get_fingerprints(fingerprints);
+  size_t offset = sizeof(*header);
+  for (uint32_t i = 0; i < header->record_count && offset + sizeof(struct cache_record) <= len; i++) {
+    struct cache_record record;
+    memcpy(&record, cache + offset, sizeof(record));
+    if (record.field >= CACHE_FIELDS || offset + sizeof(record) + record.len > len) break;
+    store_cache(record.field, cache + offset + sizeof(record), record.len, user_info);
+    found[record.field]           = true;
+    cache_collected[record.field] = record.collected;
+    if (stale && ((record.ttl && now - record.collected > record.ttl) || record.fingerprint != fingerprints[cache_fields[record.field].source]))
+      *cache_field_flag(stale, record.field) = true;
+    offset += (sizeof(record) + record.len + 7) & ~(size_t)7;
+  }
+  for (int i = 0; stale && i < CACHE_FIELDS; i++)
+    if (!found[i]) *cache_field_flag(stale, i) = true;
+  return true;
 }
 
-// reads cache file if it exists
-int read_cache(struct info* user_info) {
+// reads cache file if it exists, fields that have to be collected again are set in stale (can be NULL)
+int read_cache(struct info* user_info, struct flags* stale) {
   LOG_I("reading cache");
-  char cache_file[512];
-  sprintf(cache_file, "%s/.cache/uwufetch.cache", getenv("HOME")); // cache file location
+  char cache_file[600];
+  if (!get_cache_path("uwufetch.cache", cache_file, sizeof(cache_file))) return 0;
   LOG_V(cache_file);
-  FILE* cache_fp = fopen(cache_file, "r");
-  if (cache_fp == NULL) return 0;
-  char buffer[256];                                 // line buffer
-  int gpuc = 0;                                     // gpu counter
-  while (fgets(buffer, sizeof(buffer), cache_fp)) { // reading the file
-    sscanf(buffer, "user=%99[^\n]", user_info->user);
-    sscanf(buffer, "host=%99[^\n]", user_info->host);
-    sscanf(buffer, "version_name=%99[^\n]", user_info->os_name);
-    sscanf(buffer, "host_model=%99[^\n]", user_info->model);
-    sscanf(buffer, "kernel=%99[^\n]", user_info->kernel);
-    sscanf(buffer, "cpu=%99[^\n]", user_info->cpu_model);
-    if (sscanf(buffer, "gpu=%99[^\n]", user_info->gpu_model[gpuc]) != 0) gpuc++;
-    sscanf(buffer, "screen_width=%i", &user_info->screen_width);
-    sscanf(buffer, "screen_height=%i", &user_info->screen_height);
-    sscanf(buffer, "shell=%99[^\n]", user_info->shell);
-    sscanf(buffer, "pkgs=%i", &user_info->pkgs);
-    sscanf(buffer, "pkgman_name=%99[^\n]", user_info->pkgman_name);
+  bool loaded = false;
+#ifndef _WIN32
+  int cache_fd = open(cache_file, O_RDONLY | O_CLOEXEC);
+  if (cache_fd < 0) return 0;
+  struct stat cache_stat;
+  char* cache = NULL;
+  if (fstat(cache_fd, &cache_stat) == 0 && cache_stat.st_size > 0)
+    cache = mmap(NULL, cache_stat.st_size, PROT_READ, MAP_PRIVATE, cache_fd, 0);
+  close(cache_fd);
+  if (!cache || cache == MAP_FAILED) return 0;
+  size_t cache_len = cache_stat.st_size;
+#else
+  static char cache[sizeof(struct info) * 2];
+  FILE* cache_fp = fopen(cache_file, "rb");
+  if (!cache_fp) return 0;
+  size_t cache_len = fread(cache, 1, sizeof(cache), cache_fp);
+  fclose(cache_fp);
+#endif
+  loaded = read_cache_records(cache, cache_len, user_info, stale);
+  if (!loaded) { // text cache, from -w of older versions or an export
+    LOG_I("reading the text cache, every field will be collected again");
+    loaded = scan_keys(cache, cache_len, '=', cache_keys, CACHE_FIELDS, store_cache, user_info) > 0;
+    if (stale) memset(stale, true, sizeof(*stale));
   }
+#ifndef _WIN32
+  munmap(cache, cache_len);
+#endif
   LOG_V(user_info->user);
   LOG_V(user_info->host);
   LOG_V(user_info->os_name);
   LOG_V(user_info->model);
   LOG_V(user_info->kernel);
   LOG_V(user_info->cpu_model);
-  LOG_V(user_info->gpu_model[gpuc]);
+  LOG_V(user_info->gpu_count);
   LOG_V(user_info->screen_width);
   LOG_V(user_info->screen_height);
+  LOG_V(user_info->monitor_count);
   LOG_V(user_info->shell);
   LOG_V(user_info->pkgs);
   LOG_V(user_info->pkgman_name);
-  fclose(cache_fp);
+  return loaded;
+}
+
+// fills the fields get_info stopped waiting for at the deadline with their last cached values, and takes them out of
+// fresh (if not NULL) so that the cache keeps the time they were collected at. ram and uptime are not cached, they are
+// left to get_live_info
+void fill_from_cache(struct info* user_info, struct flags* fresh) {
+  struct info cached;
+  if (!user_info->timed_out) return;
+  memset(&cached, 0, sizeof(cached));
+  if (read_cache(&cached, NULL)) {
+    LOG_I("filling the timed out fields from the cache");
+    info_copy_fields(user_info, &cached, user_info->timed_out & ~(FETCH_RAM | FETCH_UPTIME));
+  }
+  for (size_t i = 0; fresh && i < sizeof(*fresh); i++)
+    if (user_info->timed_out >> i & 1) ((bool*)fresh)[i] = false; // struct flags is in the order of the FETCH_* fields
+}
+
+// refreshes the cache in a detached process, unless it was written recently or another process is already refreshing it
+void refresh_cache(struct configuration* config_flags) {
+#ifndef _WIN32
+  char cache_file[600];
+  struct stat cache_stat;
+  if (!get_cache_path("uwufetch.cache", cache_file, sizeof(cache_file))) return;
+  if (stat(cache_file, &cache_stat) == 0 && time(NULL) - cache_stat.st_mtime < CACHE_REFRESH_INTERVAL) return;
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid != 0) {
+    if (pid > 0) waitpid(pid, NULL, 0); // the refresher is the grandchild, this one exits right away
+    return;
+  }
+  setsid(); // not killed with the terminal
+  if (fork() != 0) _exit(0);
+  // parallel shells all get here, only the one holding the lock refreshes
+  if (lock_cache(false) < 0) _exit(0);
+  if (stat(cache_file, &cache_stat) == 0 && time(NULL) - cache_stat.st_mtime < CACHE_REFRESH_INTERVAL) _exit(0); // refreshed while waiting
+  LOG_I("refreshing the cache in the background");
+  int null_fd = open("/dev/null", O_RDWR);
+  for (int fd = 0; null_fd >= 0 && fd < 3; fd++) dup2(null_fd, fd);
+  struct info user_info = {0};
+  struct flags fresh    = config_flags->show;
+  user_info.deadline    = config_flags->deadline;
+  get_info(config_flags->show, &user_info);
+  fill_from_cache(&user_info, &fresh);
+  write_cache(&user_info, &fresh);
+  _exit(0);
+#else
+  (void)config_flags;
+#endif
+}
+
+// gets the info that is never cached, ram and uptime
+void get_live_info(struct configuration* config_flags, struct info* user_info) {
+  int buf_sz = 256;
+  char buffer[buf_sz]; // line buffer
+  struct thread_varg vargp = {
+      buffer, user_info, {true, true, true, true, true, true, true, true}, NULL, 0, false};
+  if (config_flags->show.ram) get_ram(&vargp);
+  if (config_flags->show.uptime) {
+    LOG_I("getting additional not-cached info");
+    get_sys(user_info);
+    get_upt(&vargp);
+  }
+}
+
+// gets the snapshot of uwufetchd, returns false if it is not running
+bool read_daemon(struct info* user_info) {
+#ifdef __linux__
+  struct info snapshot;
+  struct snapshot_header header;
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  struct timeval timeout  = {0, DAEMON_TIMEOUT * 1000};
+  if (!get_cache_path(UWUFETCHD_SOCKET, addr.sun_path, sizeof(addr.sun_path))) return false;
+  int daemon_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (daemon_fd < 0) return false;
+  setsockopt(daemon_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  bool received = connect(daemon_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+                  recv(daemon_fd, &header, sizeof(header), MSG_WAITALL) == sizeof(header) &&
+                  memcmp(header.magic, UWUFETCHD_MAGIC, sizeof(header.magic)) == 0 && header.version == UWUFETCHD_VERSION &&
+                  header.info_size == sizeof(snapshot) && recv(daemon_fd, &snapshot, sizeof(snapshot), MSG_WAITALL) == sizeof(snapshot);
+  close(daemon_fd);
+  if (!received) return false;
+  info_sanitize(&snapshot);
+  memcpy(snapshot.image_name, user_info->image_name, sizeof(snapshot.image_name)); // set by the config
+  memcpy(user_info, &snapshot, sizeof(snapshot));
+  get_twidth(user_info); // the terminal of this process, not the one of the daemon
+  return true;
+#else
+  (void)user_info;
+  return false;
+#endif
+}
+
+#ifndef _WIN32
+// system-wide info published by root with --publish and mapped by every user
+// it is rewritten in place, readers copy it while seq is even and unchanged (a seqlock) so they never block or see torn data
+struct published_snapshot {
+  uint32_t seq; // odd while publishing
+  struct snapshot_header header;
+  char boot_id[40]; // of the system that published it
+  int64_t published;
+  struct info info;
+};
+#endif
+
+// collects the info shared by all the users and publishes it in SNAPSHOT_FILE
+int publish_snapshot(struct info* user_info) {
+#ifndef _WIN32
+  // user and shell change with the user, ram and uptime are always read live
+  user_info->pkg_scope = PKGS_SYSTEM; // not the package managers in the home of root
+  get_info((struct flags){false, false, true, true, true, true, true, true, false, true, false}, user_info);
+  if (mkdir(SNAPSHOT_DIR, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "can not create %s: %s\n", SNAPSHOT_DIR, strerror(errno));
+    return 1;
+  }
+  int snapshot_fd = open(SNAPSHOT_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  struct published_snapshot* snapshot = MAP_FAILED;
+  // publishers take turns, two writers at once would break the seqlock
+  if (snapshot_fd >= 0 && flock(snapshot_fd, LOCK_EX) == 0 && fchmod(snapshot_fd, 0644) == 0 && ftruncate(snapshot_fd, sizeof(*snapshot)) == 0)
+    snapshot = mmap(NULL, sizeof(*snapshot), PROT_READ | PROT_WRITE, MAP_SHARED, snapshot_fd, 0);
+  if (snapshot == MAP_FAILED) {
+    fprintf(stderr, "can not write %s: %s\n", SNAPSHOT_FILE, strerror(errno));
+    if (snapshot_fd >= 0) close(snapshot_fd);
+    return 1;
+  }
+  struct snapshot_header header = {UWUFETCHD_MAGIC, UWUFETCHD_VERSION, sizeof(struct info)};
+  char boot_id[sizeof(snapshot->boot_id)];
+  get_boot_id(boot_id, sizeof(boot_id));
+  uint32_t seq                  = (__atomic_load_n(&snapshot->seq, __ATOMIC_RELAXED) + 1) | 1; // still odd if a publisher died halfway
+  __atomic_store_n(&snapshot->seq, seq, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&snapshot->header, &header, sizeof(header));
+  memcpy(snapshot->boot_id, boot_id, sizeof(boot_id));
+  snapshot->published = time(NULL);
+  memcpy(&snapshot->info, user_info, sizeof(*user_info));
+  __atomic_store_n(&snapshot->seq, seq + 1, __ATOMIC_RELEASE);
+  munmap(snapshot, sizeof(*snapshot));
+  close(snapshot_fd);
+  return 0;
+#else
+  (void)user_info;
+  fprintf(stderr, "--publish is not supported on Windows\n");
   return 1;
+#endif
 }
 
+// gets the info published by root, filling the fields of this user, returns false if there is no snapshot
+bool read_snapshot(struct configuration* config_flags, struct info* user_info) {
+#ifndef _WIN32
+  struct info copy;
+  struct snapshot_header header;
+  char boot_id[sizeof(((struct published_snapshot*)0)->boot_id)], current_boot_id[sizeof(boot_id)];
+  int64_t published = 0;
+  struct stat snapshot_stat;
+  int snapshot_fd = open(SNAPSHOT_FILE, O_RDONLY | O_CLOEXEC);
+  if (snapshot_fd < 0) return false;
+  struct published_snapshot* snapshot = MAP_FAILED;
+  if (fstat(snapshot_fd, &snapshot_stat) == 0 && snapshot_stat.st_size >= (off_t)sizeof(*snapshot))
+    snapshot = mmap(NULL, sizeof(*snapshot), PROT_READ, MAP_SHARED, snapshot_fd, 0);
+  close(snapshot_fd);
+  if (snapshot == MAP_FAILED) return false;
+  bool copied = false;
+  for (int i = 0; i < SNAPSHOT_RETRIES && !copied; i++) {
+    uint32_t seq = __atomic_load_n(&snapshot->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) { // being published
+      sched_yield();
+      continue;
+    }
+    memcpy(&header, &snapshot->header, sizeof(header));
+    memcpy(boot_id, snapshot->boot_id, sizeof(boot_id));
+    published = snapshot->published;
+    memcpy(&copy, &snapshot->info, sizeof(copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    copied = __atomic_load_n(&snapshot->seq, __ATOMIC_RELAXED) == seq;
+  }
+  munmap(snapshot, sizeof(*snapshot));
+  if (!copied || memcmp(header.magic, UWUFETCHD_MAGIC, sizeof(header.magic)) != 0 || header.version != UWUFETCHD_VERSION ||
+      header.info_size != sizeof(copy))
+    return false;
+  // published before a reboot or too long ago, the system may have changed since
+  get_boot_id(current_boot_id, sizeof(current_boot_id));
+  int64_t age = time(NULL) - published;
+  if (strncmp(boot_id, current_boot_id, sizeof(boot_id)) != 0 || age < 0 || age > SNAPSHOT_MAX_AGE) {
+    LOG_W("the snapshot in %s is stale, collecting the info", SNAPSHOT_FILE);
+    return false;
+  }
+  info_sanitize(&copy);
+  memcpy(copy.image_name, user_info->image_name, sizeof(copy.image_name)); // set by the config
+  memcpy(user_info, &copy, sizeof(copy));
+  LOG_I("using the snapshot published in %s", SNAPSHOT_FILE);
+  user_info->pkg_scope = PKGS_USER; // the package managers in the home of this user are added to the published ones
+  get_info((struct flags){.user = config_flags->show.user, .shell = config_flags->show.shell, .pkgs = config_flags->show.pkgs}, user_info);
+  user_info->pkg_scope = PKGS_ALL;
+  return true;
+#else
+  (void)config_flags;
+  (void)user_info;
+  return false;
+#endif
+}
+
+// color placeholders of the ascii logos
+static const char* const color_rules[][2] = {
+#define PLACEHOLDER(name) {"{" #name "}", name},
+    LOGO_PLACEHOLDERS
+#undef PLACEHOLDER
+};
+
 // prints logo (as ascii art) of the given system.
 int print_ascii(struct info* user_info) {
-  FILE* file;
+  FILE* file = NULL;
   char ascii_file[1024];
-  // First tries to get ascii art file from local directory. Useful for debugging
-  sprintf(ascii_file, "./res/ascii/%s.txt", user_info->os_name);
+  // logos on disk replace the embedded ones: the one of the user, and with make ascii_debug the one being edited
+  const char* logo = distro_logo(user_info->os_name);
+#ifdef ASCII_DEBUG
+  sprintf(ascii_file, "./res/ascii/%s.txt", logo);
   LOG_V(ascii_file);
   file = fopen(ascii_file, "r");
-  if (!file) { // if the file does not exist in the local directory, open it from the installation directory
+#endif
+  if (!file && getenv("HOME")) {
+    snprintf(ascii_file, sizeof(ascii_file), "%s/.config/uwufetch/ascii/%s.txt", getenv("HOME"), logo);
+    LOG_V(ascii_file);
+    file = fopen(ascii_file, "r");
+  }
+  for (size_t i = 0; !file && i < sizeof(embedded_logos) / sizeof(embedded_logos[0]); i++)
+    if (strcmp(embedded_logos[i].name, logo) == 0) {
+      if (embedded_logos[i].width >= atoi(MOVE_CURSOR + 2)) { // the info goes after the widest line
+        static char move_cursor[16];
+        snprintf(move_cursor, sizeof(move_cursor), "\033[%dC", embedded_logos[i].width + 1);
+        MOVE_CURSOR = move_cursor;
+      }
+      fwrite(embedded_logos[i].text, 1, embedded_logos[i].len, stdout);
+      return embedded_logos[i].height + 1;
+    }
+  if (!file) { // logos installed after this build, from the installation directory
     if (strcmp(user_info->os_name, "android") == 0)
-      sprintf(ascii_file, "/data/data/com.termux/files/usr/lib/uwufetch/ascii/%s.txt", user_info->os_name);
+      sprintf(ascii_file, "/data/data/com.termux/files/usr/lib/uwufetch/ascii/%s.txt", logo);
     else if (strcmp(user_info->os_name, "macos") == 0)
-      sprintf(ascii_file, "/usr/local/lib/uwufetch/ascii/%s.txt", user_info->os_name);
+      sprintf(ascii_file, "/usr/local/lib/uwufetch/ascii/%s.txt", logo);
     else
-      sprintf(ascii_file, "/usr/lib/uwufetch/ascii/%s.txt", user_info->os_name);
+      sprintf(ascii_file, "/usr/lib/uwufetch/ascii/%s.txt", logo);
     LOG_V(ascii_file);
 
     file = fopen(ascii_file, "r");
@@ -635,26 +1247,12 @@ int print_ascii(struct info* user_info) {
   char buffer[256]; // line buffer
   int line_count = 1;
   printf("\n");
+  static struct uwufier color_uwufier;
+  if (!color_uwufier.state_count) build_uwufier(&color_uwufier, color_rules, sizeof(color_rules) / sizeof(color_rules[0]), false);
+  char colored[1024];
   while (fgets(buffer, 256, file)) { // replacing color placecholders
-    replace(buffer, "{NORMAL}", NORMAL);
-    replace(buffer, "{BOLD}", BOLD);
-    replace(buffer, "{BLACK}", BLACK);
-    replace(buffer, "{RED}", RED);
-    replace(buffer, "{GREEN}", GREEN);
-    replace(buffer, "{SPRING_GREEN}", SPRING_GREEN);
-    replace(buffer, "{YELLOW}", YELLOW);
-    replace(buffer, "{BLUE}", BLUE);
-    replace(buffer, "{MAGENTA}", MAGENTA);
-    replace(buffer, "{CYAN}", CYAN);
-    replace(buffer, "{WHITE}", WHITE);
-    replace(buffer, "{PINK}", PINK);
-    replace(buffer, "{LPINK}", LPINK);
-    replace(buffer, "{BLOCK}", BLOCK_CHAR);
-    replace(buffer, "{BLOCK_VERTICAL}", BLOCK_CHAR);
-    replace(buffer, "{BACKGROUND_GREEN}", "\e[0;42m");
-    replace(buffer, "{BACKGROUND_RED}", "\e[0;41m");
-    replace(buffer, "{BACKGROUND_WHITE}", "\e[0;47m");
-    printf("%s", buffer); // print the line after setting the color
+    uwufy(&color_uwufier, buffer, colored, sizeof(colored));
+    printf("%s", colored); // print the line after setting the color
     line_count++;
   }
   // Always set color to NORMAL, so there's no need to do this in every ascii file.
@@ -668,21 +1266,26 @@ int print_ascii(struct info* user_info) {
    to make the output easier to understand by the user.*/
 void list(char* arg) {
   LOG_I("printing supported distro list");
-  // clang-format off
-	printf("%s -d <options>\n"
-				 "  Available distributions:\n"
-				 "    "BLUE"Arch linux "NORMAL"based:\n"
-				 "      "BLUE"arch, arcolinux, "MAGENTA"artix, endeavouros "GREEN"manjaro, manjaro-arm, "BLUE"xerolinux\n\n"
-				 "    "RED"Debian/"YELLOW"Ubuntu "NORMAL"based:\n"
-				 "      "RED"amogos, debian, deepin, "GREEN"linuxmint, neon, "BLUE"pop, "RED"raspbian "YELLOW"ubuntu\n\n"
-				 "    "RED"BSD "NORMAL"based:\n"
-				 "      "RED"freebsd, "YELLOW"openbsd, "GREEN"m"YELLOW"a"RED"c"PINK"o"BLUE"s, "WHITE"ios\n\n"
-				 "    "RED"RHEL "NORMAL"based:\n"
-				 "      "BLUE"fedora, "GREEN"rocky\n\n"
-				 "    "NORMAL"Other/spare distributions:\n"
-				 "      "BLUE"alpine, "PINK"femboyos, gentoo, "MAGENTA"slackware, "WHITE"solus, "GREEN"void, opensuse-leap, android, "YELLOW"gnu, guix, "BLUE"windows, "WHITE"unknown\n\n",
-				 arg); // Other/spare distributions colors
-  // clang-format on
+  const char* groups[] = {BLUE "Arch linux " NORMAL "based:", RED "Debian/" YELLOW "Ubuntu " NORMAL "based:", RED "BSD " NORMAL "based:",
+                          RED "RHEL " NORMAL "based:", NORMAL "Other/spare distributions:"};
+  const char* rainbow[] = {GREEN, YELLOW, RED, PINK, BLUE};
+  printf("%s -d <options>\n"
+         "  Available distributions:\n",
+         arg);
+  for (int group = 0; group < NOT_LISTED; group++) {
+    printf("    %s\n      ", groups[group]);
+    bool first = true;
+    for (size_t i = 0; i < sizeof(distros) / sizeof(distros[0]); i++) {
+      if ((int)distros[i].group != group) continue;
+      printf("%s", first ? "" : ", ");
+      first = false;
+      if (distros[i].color)
+        printf("%s%s", distros[i].color, distros[i].id);
+      else
+        for (int j = 0; distros[i].id[j]; j++) printf("%s%c", rainbow[j % 5], distros[i].id[j]);
+    }
+    printf(NORMAL "\n\n");
+  }
 }
 
 // prints the usage
@@ -691,6 +1294,9 @@ void usage(char* arg) {
   printf("Usage: %s <args>\n"
          "    -c  --config        use custom config path\n"
          "    -d, --distro        lets you choose the logo to print\n"
+         "        --deadline <ms> kills commands still running after <ms> milliseconds,\n"
+         "                        showing their last cached values instead\n"
+         "    -e, --export-cache  prints the cache file in its text format\n"
          "    -h, --help          prints this help page\n"
 #ifndef __IPHONE__
          "    -i, --image         prints logo as image and use a custom image "
@@ -703,12 +1309,14 @@ void usage(char* arg) {
 #endif
          "                        read README.md for more info%s\n"
          "    -l, --list          lists all supported distributions\n"
+         "        --publish       publishes the info shared by all users in " SNAPSHOT_FILE " (as root)\n"
          "    -V, --version       prints the current uwufetch version\n"
 #ifdef __DEBUG__
          "    -v, --verbose       logs everything\n"
 #endif
-         "    -w, --write-cache   writes to the cache file (~/.cache/uwufetch.cache)\n"
-         "    -r, --read-cache    reads from the cache file (~/.cache/uwufetch.cache)\n",
+         "    -w, --write-cache   writes to the cache file\n"
+         "    -r, --read-cache    reads from the cache file\n"
+         "    -s, --stale-cache   reads from the cache file and refreshes it in the background\n",
          arg,
 #ifndef __IPHONE__
          BLUE,
@@ -737,11 +1345,15 @@ int main(int argc, char* argv[]) {
   int opt                      = 0;
   struct option long_options[] = {
       {"config", required_argument, NULL, 'c'},
+      {"deadline", required_argument, NULL, 'D'},
       {"distro", required_argument, NULL, 'd'},
+      {"export-cache", no_argument, NULL, 'e'},
       {"help", no_argument, NULL, 'h'},
       {"image", optional_argument, NULL, 'i'},
       {"list", no_argument, NULL, 'l'},
+      {"publish", no_argument, NULL, 'P'},
       {"read-cache", no_argument, NULL, 'r'},
+      {"stale-cache", no_argument, NULL, 's'},
       {"version", no_argument, NULL, 'V'},
 #ifdef __DEBUG__
       {"verbose", no_argument, NULL, 'v'},
@@ -749,9 +1361,9 @@ int main(int argc, char* argv[]) {
       {"write-cache", no_argument, NULL, 'w'},
       {0}};
 #ifdef __DEBUG__
-  #define OPT_STRING "c:d:hi::lrVvw"
+  #define OPT_STRING "c:d:ehi::lrsVvw"
 #else
-  #define OPT_STRING "c:d:hi::lrVw"
+  #define OPT_STRING "c:d:ehi::lrsVw"
 #endif
 
   // reading cmdline options
@@ -761,9 +1373,15 @@ int main(int argc, char* argv[]) {
       user_config_file.config_directory = optarg;
       config_flags                      = parse_config(&user_info, &user_config_file);
       break;
+    case 'D': // limit the time spent waiting for commands
+      config_flags.deadline = atoi(optarg) > 0 ? atoi(optarg) : 0;
+      break;
     case 'd': // set the distribution name
       custom_distro_name = optarg;
       break;
+    case 'e': // print the cache in its text format
+      user_config_file.export_enabled = true;
+      break;
     case 'h':
       usage(argv[0]);
       return 0;
@@ -774,9 +1392,16 @@ int main(int argc, char* argv[]) {
     case 'l':
       list(argv[0]);
       return 0;
+    case 'P': // publish the system-wide snapshot
+      user_config_file.publish_enabled = true;
+      break;
     case 'r':
       user_config_file.read_enabled = true;
       break;
+    case 's':
+      user_config_file.read_enabled    = true;
+      user_config_file.refresh_enabled = true;
+      break;
     case 'V':
       printf("UwUfetch version %s\n", UWUFETCH_VERSION);
       return 0;
@@ -794,31 +1419,65 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  set_cache_dir(config_flags.cache_dir);
+  if (user_config_file.publish_enabled) return publish_snapshot(&user_info);
+  if (user_config_file.export_enabled) {
+    if (!read_cache(&user_info, NULL)) return 1;
+    export_cache(stdout, &user_info);
+    return 0;
+  }
+  int lock_fd = -1; // held while collecting values for the cache
   if (user_config_file.read_enabled) {
+    struct flags stale = {0};
+    bool cached        = read_cache(&user_info, &stale);
+    if (!cached) { // parallel runs without a cache wait for the first one to write it
+      lock_fd = lock_cache(true);
+      cached  = read_cache(&user_info, &stale);
+    }
     // if no cache file found write to it
-    if (!read_cache(&user_info)) {
+    if (!cached) {
       user_config_file.read_enabled  = false;
       user_config_file.write_enabled = true;
     } else {
-      int buf_sz = 256;
-      char buffer[buf_sz]; // line buffer
-      struct thread_varg vargp = {
-          buffer, &user_info, NULL, {true, true, true, true, true, true, true, true}};
-      if (config_flags.show.ram) get_ram(&vargp);
-      if (config_flags.show.uptime) {
-        LOG_I("getting additional not-cached info");
-        get_sys(&user_info);
-        get_upt(&vargp);
+      // fields that expired or whose source changed are collected again, the stale mode leaves them to the refresh
+      struct flags refresh = {0};
+      bool* stale_flags    = (bool*)&stale;
+      bool* show_flags     = (bool*)&config_flags.show;
+      bool* refresh_flags  = (bool*)&refresh;
+      bool refreshing      = false;
+      for (size_t i = 0; !user_config_file.refresh_enabled && i < sizeof(refresh); i++)
+        refreshing |= refresh_flags[i] = stale_flags[i] && show_flags[i];
+      // only one process collects them, the others show the previous generation
+      if (refreshing && (lock_fd >= 0 || (lock_fd = lock_cache(false)) >= 0)) {
+        LOG_I("collecting the stale fields of the cache");
+        clear_fields(&user_info, &refresh);
+        user_info.deadline = config_flags.deadline;
+        get_info(refresh, &user_info);
+        fill_from_cache(&user_info, &refresh);
+        write_cache(&user_info, &refresh);
       }
+      get_live_info(&config_flags, &user_info);
     }
   }
-  if (!user_config_file.read_enabled)
+  struct flags fresh; // fields written to the cache that were just collected, not filled from it
+  memset(&fresh, true, sizeof(fresh));
+  if (!user_config_file.read_enabled && read_daemon(&user_info)) {
+    LOG_I("using the info collected by uwufetchd");
+    get_live_info(&config_flags, &user_info);
+  } else if (!user_config_file.read_enabled && read_snapshot(&config_flags, &user_info))
+    get_live_info(&config_flags, &user_info);
+  else if (!user_config_file.read_enabled) {
+    user_info.deadline = config_flags.deadline;
     get_info(config_flags.show, &user_info);
-  LOG_V(user_info.gpu_model[1]);
+    fill_from_cache(&user_info, &fresh);
+    if (user_info.timed_out & (FETCH_RAM | FETCH_UPTIME)) get_live_info(&config_flags, &user_info);
+  }
+  LOG_V(user_info.gpu_count);
 
   if (user_config_file.write_enabled) {
-    write_cache(&user_info);
+    write_cache(&user_info, &fresh);
   }
+  unlock_cache(lock_fd);
   if (custom_distro_name) sprintf(user_info.os_name, "%s", custom_distro_name);
   if (custom_image_name) sprintf(user_info.image_name, "%s", custom_image_name);
 
@@ -830,6 +1489,7 @@ int main(int argc, char* argv[]) {
   // print info and move cursor down if the number of printed lines is smaller that the default image height
   int to_move = 9 - print_info(&config_flags, &user_info);
   printf("\033[%d%c", to_move < 0 ? -to_move : to_move, to_move < 0 ? 'A' : 'B');
+  if (user_config_file.read_enabled && user_config_file.refresh_enabled) refresh_cache(&config_flags);
   LOG_I("Execution completed successfully!");
   return 0;
 }
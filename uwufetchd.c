@@ -0,0 +1,383 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// uwufetchd keeps the info collected by libfetch warm and serves it to uwufetch over a unix socket.
+// Linux only: package databases, os-release and the config are watched with inotify, monitors with the kernel uevents.
+
+#ifndef UWUFETCH_VERSION
+  #define UWUFETCH_VERSION "unkown" // needs to be changed by the build script
+#endif
+
+#define _GNU_SOURCE // for accept4 and memmem
+
+#include "fetch.h"
+#include "uwufetchd.h"
+#include <errno.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <limits.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <signal.h>
+#include <stddef.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+
+#define REFRESH_DELAY 500 // milliseconds from the first event before the changed fields are collected, package managers write many files
+#define SEND_TIMEOUT 100  // milliseconds a client has to read the snapshot
+
+#ifdef __DEBUG__
+static bool* verbose_enabled = NULL;
+#endif
+
+// directories whose changes make a field stale, ~ is the home of the user running the daemon
+static const struct watched_path {
+  const char* path; // directory watched
+  const char* name; // file of the directory that has to change, NULL for any
+  size_t field;     // offset of the flag of the field in struct flags
+  bool link;        // path is a symbolic link replaced on every change, the directory of its target is watched
+} watched_paths[] = {
+    {"/etc", "os-release", offsetof(struct flags, os), false},
+    {"/usr/lib", "os-release", offsetof(struct flags, os), false},
+    {"/var/lib/dpkg", "status", offsetof(struct flags, pkgs), false},
+    {"/lib/apk/db", "installed", offsetof(struct flags, pkgs), false},
+    {"/var/lib/pacman/local", NULL, offsetof(struct flags, pkgs), false},
+    {"/var/lib/rpm", NULL, offsetof(struct flags, pkgs), false},
+    {"/var/db/xbps", NULL, offsetof(struct flags, pkgs), false},
+    {"/var/db/pkg", NULL, offsetof(struct flags, pkgs), false},
+    {"/var/lib/flatpak/app", NULL, offsetof(struct flags, pkgs), false},
+    {"/var/lib/flatpak/runtime", NULL, offsetof(struct flags, pkgs), false},
+    {"~/.local/share/flatpak/app", NULL, offsetof(struct flags, pkgs), false},
+    {"~/.local/share/flatpak/runtime", NULL, offsetof(struct flags, pkgs), false},
+    {"/var/lib/snapd/snaps", NULL, offsetof(struct flags, pkgs), false},
+    {"/nix/var/nix/db", NULL, offsetof(struct flags, pkgs), false},
+    {"~/.guix-profile", NULL, offsetof(struct flags, pkgs), true}, // guix adds a generation link next to the profile
+    {"/home/linuxbrew/.linuxbrew/Cellar", NULL, offsetof(struct flags, pkgs), false},
+};
+#define WATCHED_PATHS (int)(sizeof(watched_paths) / sizeof(watched_paths[0]))
+
+static struct info snapshot;                 // served to the clients
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool refreshing;                      // a refresh thread is running, guarded by snapshot_lock
+static volatile sig_atomic_t running = true; // cleared by SIGINT and SIGTERM
+
+static void stop(int signal) {
+  (void)signal;
+  running = false;
+}
+
+// scan_fn storing the cache directory of the config
+static void store_cache_dir(int key, const char* value, size_t len, void* arg) {
+  (void)key;
+  (void)len;
+  sscanf(value, "%511s", (char*)arg);
+}
+
+// config files read by read_config, in order: the one given with -c, or the one of the user and then the system one
+static char config_paths[2][PATH_MAX];
+
+// reads cache_dir from the first config of config_paths that exists, the socket has to be where uwufetch looks for it
+static void read_config(char* cache_dir) {
+  static const char* const config_keys[] = {"cache_dir"};
+  char buffer[4096];
+  cache_dir[0] = '\0';
+  for (int i = 0; i < 2 && config_paths[i][0]; i++)
+    if (scan_file(config_paths[i], buffer, sizeof(buffer), '=', config_keys, 1, store_cache_dir, cache_dir) >= 0) return;
+}
+
+// starts watching the directories of the config files (editors replace them), with -1 in watches for those missing
+static void watch_config(int inotify_fd, int watches[2]) {
+  for (int i = 0; i < 2; i++) {
+    char dir[PATH_MAX];
+    memcpy(dir, config_paths[i], sizeof(dir));
+    watches[i] = -1;
+    if (inotify_fd >= 0 && config_paths[i][0])
+      watches[i] = inotify_add_watch(inotify_fd, dirname(dir), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+  }
+}
+
+// collects the fields set in argp (a struct flags to free) and replaces them in the snapshot
+static void* refresh_fields(void* argp) {
+  struct flags* fields = argp;
+  static struct info fresh; // only one refresh runs at a time
+  memset(&fresh, 0, sizeof(fresh));
+  get_info(*fields, &fresh);
+  pthread_mutex_lock(&snapshot_lock);
+  if (fields->os) memcpy(snapshot.os_name, fresh.os_name, sizeof(snapshot.os_name));
+  if (fields->pkgs) {
+    snapshot.pkgs = fresh.pkgs;
+    memcpy(snapshot.pkgman_name, fresh.pkgman_name, sizeof(snapshot.pkgman_name));
+  }
+  if (fields->resolution) {
+    snapshot.screen_width  = fresh.screen_width;
+    snapshot.screen_height = fresh.screen_height;
+    snapshot.monitor_count = fresh.monitor_count;
+    memcpy(snapshot.monitors, fresh.monitors, sizeof(snapshot.monitors));
+  }
+  refreshing = false;
+  pthread_mutex_unlock(&snapshot_lock);
+  LOG_I("refreshed the changed fields");
+  free(fields);
+  return NULL;
+}
+
+// starts refreshing the pending fields, unless a refresh is still running, returns true if it started
+static bool start_refresh(struct flags* pending) {
+  pthread_mutex_lock(&snapshot_lock);
+  bool busy  = refreshing;
+  refreshing = true;
+  pthread_mutex_unlock(&snapshot_lock);
+  if (busy) return false;
+  struct flags* fields = malloc(sizeof(*fields));
+  pthread_t thread;
+  if (fields) *fields = *pending;
+  if (!fields || pthread_create(&thread, NULL, refresh_fields, fields) != 0) {
+    free(fields);
+    pthread_mutex_lock(&snapshot_lock);
+    refreshing = false;
+    pthread_mutex_unlock(&snapshot_lock);
+    return false;
+  }
+  pthread_detach(thread);
+  memset(pending, 0, sizeof(*pending));
+  return true;
+}
+
+// sends the snapshot to a client
+static void serve(int listen_fd) {
+  static struct info sent;
+  struct snapshot_header header = {UWUFETCHD_MAGIC, UWUFETCHD_VERSION, sizeof(struct info)};
+  struct timeval timeout        = {0, SEND_TIMEOUT * 1000};
+  int client_fd                 = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+  if (client_fd < 0) return;
+  setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  pthread_mutex_lock(&snapshot_lock);
+  memcpy(&sent, &snapshot, sizeof(sent));
+  pthread_mutex_unlock(&snapshot_lock);
+  if (send(client_fd, &header, sizeof(header), MSG_NOSIGNAL) == sizeof(header))
+    send(client_fd, &sent, sizeof(sent), MSG_NOSIGNAL);
+  close(client_fd);
+}
+
+static long long now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// starts watching a path of watched_paths, returns the watch descriptor or -1
+static int add_watch(int inotify_fd, const struct watched_path* watched) {
+  char path[PATH_MAX], target[PATH_MAX];
+  const char* home = getenv("HOME");
+  if (watched->path[0] == '~' && !home) return -1;
+  snprintf(path, sizeof(path), "%s%s", watched->path[0] == '~' ? home : "", watched->path + (watched->path[0] == '~'));
+  if (watched->link) {
+    ssize_t len = readlink(path, target, sizeof(target) - 1);
+    if (len <= 0) return -1;
+    target[len] = '\0';
+    if (target[0] != '/') { // relative to the directory of the link
+      char relative[PATH_MAX];
+      memcpy(relative, target, len + 1);
+      if (snprintf(target, sizeof(target), "%s/%s", dirname(path), relative) >= (int)sizeof(target)) return -1;
+    }
+    snprintf(path, sizeof(path), "%s", dirname(target));
+  }
+  return inotify_add_watch(inotify_fd, path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+}
+
+// marks the fields changed by the inotify events, and in config_changed the changes of the config files
+static void read_inotify(int inotify_fd, const int watches[], const int config_watches[2], struct flags* pending, bool* config_changed) {
+  char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  while ((len = read(inotify_fd, events, sizeof(events))) > 0) {
+    for (char* next = events; next < events + len;) {
+      struct inotify_event* event = (struct inotify_event*)next;
+      for (int i = 0; i < WATCHED_PATHS; i++)
+        if (watches[i] == event->wd && (!watched_paths[i].name || (event->len && strcmp(event->name, watched_paths[i].name) == 0)))
+          ((bool*)pending)[watched_paths[i].field] = true;
+      for (int i = 0; i < 2; i++) {
+        const char* name = strrchr(config_paths[i], '/');
+        if (config_watches[i] == event->wd && event->len && strcmp(event->name, name ? name + 1 : config_paths[i]) == 0) *config_changed = true;
+      }
+      next += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
+
+// marks the resolution as changed on drm uevents (monitors plugged or unplugged)
+static void read_uevents(int uevent_fd, struct flags* pending) {
+  char uevent[8192];
+  ssize_t len;
+  while ((len = recv(uevent_fd, uevent, sizeof(uevent), 0)) > 0)
+    if (memmem(uevent, len, "SUBSYSTEM=drm", sizeof("SUBSYSTEM=drm"))) pending->resolution = true;
+}
+
+// creates the listening socket, returns -1 if another uwufetchd is serving on it
+static int listen_socket(struct sockaddr_un* addr) {
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0) return -1;
+  if (connect(listen_fd, (struct sockaddr*)addr, sizeof(*addr)) == 0) {
+    LOG_E("uwufetchd is already running on %s", addr->sun_path);
+    close(listen_fd);
+    return -1;
+  }
+  unlink(addr->sun_path); // left by a daemon that did not exit cleanly
+  mode_t mask = umask(0077);
+  if (bind(listen_fd, (struct sockaddr*)addr, sizeof(*addr)) != 0 || listen(listen_fd, 64) != 0) {
+    umask(mask);
+    close(listen_fd);
+    return -1;
+  }
+  umask(mask);
+  return listen_fd;
+}
+
+// reads the config again and moves the socket to the new cache directory, if it changed
+static void reload_config(struct sockaddr_un* addr, int* listen_fd) {
+  char cache_dir[512];
+  struct sockaddr_un moved = {.sun_family = AF_UNIX};
+  read_config(cache_dir);
+  set_cache_dir(cache_dir);
+  if (!get_cache_path(UWUFETCHD_SOCKET, moved.sun_path, sizeof(moved.sun_path)) || strcmp(moved.sun_path, addr->sun_path) == 0) return;
+  int moved_fd = listen_socket(&moved);
+  if (moved_fd < 0) {
+    LOG_E("can not listen on %s, still serving on %s", moved.sun_path, addr->sun_path);
+    return;
+  }
+  LOG_I("the cache directory changed, serving on %s", moved.sun_path);
+  close(*listen_fd);
+  unlink(addr->sun_path);
+  *addr      = moved;
+  *listen_fd = moved_fd;
+}
+
+void usage(char* arg) {
+  printf("Usage: %s <args>\n"
+         "    -c  --config        use custom config path (only cache_dir is read, again when it changes)\n"
+         "    -h, --help          prints this help page\n"
+#ifdef __DEBUG__
+         "    -v, --verbose       logs everything\n"
+#endif
+         "    -V, --version       prints the current uwufetch version\n",
+         arg);
+}
+
+int main(int argc, char* argv[]) {
+#ifdef __DEBUG__
+  verbose_enabled = get_verbose_handle();
+#endif
+  char cache_dir[512]          = "";
+  int opt                      = 0;
+  struct option long_options[] = {
+      {"config", required_argument, NULL, 'c'},
+      {"help", no_argument, NULL, 'h'},
+#ifdef __DEBUG__
+      {"verbose", no_argument, NULL, 'v'},
+#endif
+      {"version", no_argument, NULL, 'V'},
+      {0}};
+#ifdef __DEBUG__
+  #define OPT_STRING "c:hvV"
+#else
+  #define OPT_STRING "c:hV"
+#endif
+  while ((opt = getopt_long(argc, argv, OPT_STRING, long_options, NULL)) != -1) {
+    switch (opt) {
+    case 'c':
+      snprintf(config_paths[0], sizeof(config_paths[0]), "%s", optarg);
+      break;
+    case 'h':
+      usage(argv[0]);
+      return 0;
+#ifdef __DEBUG__
+    case 'v':
+      *verbose_enabled = true;
+      break;
+#endif
+    case 'V':
+      printf("uwufetchd version %s\n", UWUFETCH_VERSION);
+      return 0;
+    default:
+      return 1;
+    }
+  }
+
+  if (!config_paths[0][0] && getenv("HOME")) {
+    snprintf(config_paths[0], sizeof(config_paths[0]), "%s/.config/uwufetch/config", getenv("HOME"));
+    snprintf(config_paths[1], sizeof(config_paths[1]), "/etc/uwufetch/config");
+  } else if (!config_paths[0][0])
+    snprintf(config_paths[0], sizeof(config_paths[0]), "/etc/uwufetch/config");
+  read_config(cache_dir);
+  set_cache_dir(cache_dir);
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  if (!get_cache_path(UWUFETCHD_SOCKET, addr.sun_path, sizeof(addr.sun_path))) {
+    fprintf(stderr, "uwufetchd: no cache directory to create the socket in\n");
+    return 1;
+  }
+  int listen_fd = listen_socket(&addr);
+  if (listen_fd < 0) {
+    fprintf(stderr, "uwufetchd: can not listen on %s\n", addr.sun_path);
+    return 1;
+  }
+
+  // watching before collecting, so that nothing changes unnoticed in between
+  int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  int watches[WATCHED_PATHS];
+  for (int i = 0; i < WATCHED_PATHS; i++)
+    watches[i] = inotify_fd < 0 ? -1 : add_watch(inotify_fd, &watched_paths[i]);
+  int config_watches[2];
+  watch_config(inotify_fd, config_watches);
+  int uevent_fd              = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+  struct sockaddr_nl uevents = {.nl_family = AF_NETLINK, .nl_groups = 1};
+  if (uevent_fd >= 0 && bind(uevent_fd, (struct sockaddr*)&uevents, sizeof(uevents)) != 0) {
+    close(uevent_fd);
+    uevent_fd = -1;
+  }
+
+  // ram and uptime always change, the client gets them by itself
+  LOG_I("collecting the first snapshot");
+  get_info((struct flags){true, true, true, true, true, true, true, true, false, true, false}, &snapshot);
+
+  struct sigaction action = {.sa_handler = stop}; // no SA_RESTART, poll has to return
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  struct flags pending = {0};
+  long long refresh_at = 0; // when the pending fields are collected, set by the first event so that clients can not delay it
+  while (running) {
+    struct pollfd fds[] = {{listen_fd, POLLIN, 0}, {inotify_fd, POLLIN, 0}, {uevent_fd, POLLIN, 0}};
+    bool waiting         = pending.os || pending.pkgs || pending.resolution;
+    long long left       = refresh_at - now_ms();
+    if (waiting && left <= 0) {
+      // retried later if the last refresh is still running
+      refresh_at = start_refresh(&pending) ? 0 : now_ms() + REFRESH_DELAY;
+      continue;
+    }
+    if (poll(fds, 3, waiting ? (int)left : -1) <= 0) continue; // timed out or interrupted by a signal
+    if (fds[0].revents & POLLIN) serve(listen_fd);
+    bool config_changed = false;
+    if (fds[1].revents & POLLIN) read_inotify(inotify_fd, watches, config_watches, &pending, &config_changed);
+    if (config_changed) reload_config(&addr, &listen_fd);
+    if (fds[2].revents & POLLIN) read_uevents(uevent_fd, &pending);
+    if (!waiting && (pending.os || pending.pkgs || pending.resolution)) refresh_at = now_ms() + REFRESH_DELAY;
+  }
+  LOG_I("stopping");
+  unlink(addr.sun_path);
+  return 0;
+}
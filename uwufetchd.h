@@ -0,0 +1,30 @@
+/*
+ *  UwUfetch is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _UWUFETCHD_H_
+#define _UWUFETCHD_H_
+#include <stdint.h>
+
+#define UWUFETCHD_SOCKET "uwufetchd.sock" // in the cache directory
+#define UWUFETCHD_MAGIC "UWUSNAP"
+#define UWUFETCHD_VERSION 3
+
+// sent before the struct info snapshot, a client built with a different struct info collects by itself
+struct snapshot_header {
+  char magic[8];
+  uint32_t version, info_size;
+};
+
+#endif // _UWUFETCHD_H_